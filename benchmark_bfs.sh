@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# time of the bfs building the distance table of each target with tablegen,
+# the other tables are linked from cache/, run it before and after a change to compare,
+# or with BFS_STRATEGY=cas and BFS_STRATEGY=partition to compare the two
+
+TABLES=${TABLES:-"p0s p1s c8"}
+N_THREAD=${N_THREAD:-4}
+BFS_STRATEGY=${BFS_STRATEGY:-cas}
+
+ROOT=$PWD
+DIR=$(mktemp -d)
+mkdir $DIR/cache
+for f in cache/*
+do
+    case $f in
+        *.distance_m3) ;;
+        *) ln -s $ROOT/$f $DIR/cache/ ;;
+    esac
+done
+
+for tables in $TABLES
+do
+    echo "tables=$tables"
+    (cd $DIR && $ROOT/tablegen --tables $tables --n_thread $N_THREAD --bfs_strategy $BFS_STRATEGY --cache_verify none) | grep -E "bfs: (strategy|depth|total)"
+    rm -f $DIR/cache/*.distance_m3
+done
+rm -rf $DIR
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# nodes per second of thread_opty on superflip with each huge page policy,
+# each run is stopped after $TIME seconds, compare the speed of the same n_moves
+
+TIME=${TIME:-600}
+N_THREAD=${N_THREAD:-4}
+
+for huge_page in none thp 2m 1g
+do
+    echo "huge_page=$huge_page"
+    timeout $TIME ./solver --algorithm thread_opty --n_thread $N_THREAD --huge_page $huge_page \
+        --input example_superflip.txt | grep -E "cache_data: huge_page|parallel_ida_star: (complete|found)"
+done
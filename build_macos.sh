@@ -1,6 +1,9 @@
 #!/bin/bash
 
 time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 src/test.cpp -o test
+time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 src/cache_tool.cpp -o cache_tool
+time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 src/tablegen.cpp -o tablegen
+time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 src/benchmark_distance.cpp -o benchmark_distance
 
 time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 -c src/solver.cpp -o solver.o
 time clang++ -std=c++17 -fconstexpr-steps=100000000 -I include/ -O2 -c src/cuda_cube.cpp -o cuda_cube_nocuda.o
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cctype>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
@@ -14,10 +15,12 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
 #include <set>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -92,31 +95,144 @@ namespace cube {
         return s;
     }
 
-    template<typename T>
-    std::unique_ptr<T> cache_data(const std::string &name, const std::function<void(T &)> &init) {
-        std::string dir = "cache/";
-        std::string path = dir + name;
-        std::unique_ptr<T> p = std::make_unique<T>();
-        if (std::filesystem::exists(path)) {
-            std::cout << "cache_data: load " << name << " ..." << std::endl;
-            std::ifstream f{path, std::ios::binary};
-            f.read(reinterpret_cast<char *>(p.get()), sizeof(T));
-            std::cout << "cache_data: load " << name << " ok" << std::endl;
-        } else {
-            std::cout << "cache_data: compute " << name << " ..." << std::endl;
-            auto t0 = std::chrono::steady_clock::now();
-            init(*p);
-            auto t1 = std::chrono::steady_clock::now();
-            std::chrono::duration<double> d = t1 - t0;
-            std::cout << "cache_data: compute " << name << " ok, time=" << d.count() << "s" << std::endl;
-            std::cout << "cache_data: save " << name << " ..." << std::endl;
-            std::filesystem::create_directory(dir);
-            std::ofstream f{path, std::ios::binary};
-            f.write(reinterpret_cast<const char *>(p.get()), sizeof(T));
-            std::cout << "cache_data: save " << name << " ok" << std::endl;
-        }
-        return p;
+    //  calls f(start, end) for n_thread contiguous ranges of [0, n), each on its own thread
+    inline void parallel_for(u64 n, u64 n_thread, const std::function<void(u64, u64)> &f) {
+        std::vector<std::future<void>> future{};
+        for (u64 i = 0; i < n_thread; i++) {
+            future.push_back(std::async(std::launch::async, f, n * i / n_thread, n * (i + 1) / n_thread));
+        }
+        for (u64 i = 0; i < n_thread; i++) {
+            future[i].get();
+        }
     }
+
+    //  n_thread threads kept for many rounds of work, run(f) calls f(thread index) on each of them and waits
+    struct worker_pool {
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::function<void(u64)> task;
+        u64 round = 0;
+        u64 n_running = 0;
+        bool stop = false;
+
+        explicit worker_pool(u64 n_thread) {
+            for (u64 i = 0; i < n_thread; i++) {
+                threads.emplace_back([this, i]() -> void {
+                    work(i);
+                });
+            }
+        }
+
+        ~worker_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            cv.notify_all();
+            for (std::thread &t: threads) {
+                t.join();
+            }
+        }
+
+        u64 size() const {
+            return threads.size();
+        }
+
+        void run(const std::function<void(u64)> &f) {
+            std::unique_lock<std::mutex> lock(mutex);
+            task = f;
+            round++;
+            n_running = threads.size();
+            cv.notify_all();
+            cv.wait(lock, [this]() -> bool {
+                return n_running == 0;
+            });
+        }
+
+        void work(u64 i) {
+            u64 done = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                cv.wait(lock, [this, done]() -> bool {
+                    return stop or round != done;
+                });
+                if (stop) {
+                    return;
+                }
+                done = round;
+                lock.unlock();
+                task(i);
+                lock.lock();
+                if (--n_running == 0) {
+                    cv.notify_all();
+                }
+            }
+        }
+    };
+
+    //  name and element counts of a table type, written into the cache file header,
+    //  each table type has its own specialization, so the name is the same with every compiler
+    template<typename T>
+    struct type_desc;
+
+    template<>
+    struct type_desc<u8> {
+        static std::string name() {
+            return "u8";
+        }
+
+        static std::vector<u64> shape() {
+            return {};
+        }
+    };
+
+    template<>
+    struct type_desc<u16> {
+        static std::string name() {
+            return "u16";
+        }
+
+        static std::vector<u64> shape() {
+            return {};
+        }
+    };
+
+    template<>
+    struct type_desc<u32> {
+        static std::string name() {
+            return "u32";
+        }
+
+        static std::vector<u64> shape() {
+            return {};
+        }
+    };
+
+    template<>
+    struct type_desc<u64> {
+        static std::string name() {
+            return "u64";
+        }
+
+        static std::vector<u64> shape() {
+            return {};
+        }
+    };
+
+    template<typename T, u64 n>
+    struct type_desc<std::array<T, n>> {
+        static std::string name() {
+            return "array<" + type_desc<T>::name() + ">";
+        }
+
+        static std::vector<u64> shape() {
+            std::vector<u64> s{n};
+            std::vector<u64> s_t = type_desc<T>::shape();
+            s.insert(s.end(), s_t.begin(), s_t.end());
+            return s;
+        }
+    };
 }
 
 #endif
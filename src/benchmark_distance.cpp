@@ -0,0 +1,226 @@
+#include <sstream>
+
+#include "cxxopts.hpp"
+
+#include "base.h"
+#include "cache.h"
+#include "search.h"
+#include "cube2.h"
+#include "cube3.h"
+#include "cube3_2p.h"
+#include "cube3_opt.h"
+
+using namespace cube;
+using namespace cube::_2;
+using namespace cube::_3;
+using namespace cube::_3::_2p;
+using namespace cube::_3::opt;
+
+//  time of get_distance on the root state of random cubes, and of ida_star up to the first solution of each,
+//  distance_sum is the same for solvers with the same states
+template<typename _solver, u64 capacity>
+void benchmark_one(const std::string &name, u64 n_thread, u64 seed, u64 n_cube, u64 rand_n_moves, u64 max_n_moves) {
+    std::cout << "##################################################" << std::endl;
+    auto t0 = std::chrono::steady_clock::now();
+    _solver s(n_thread);
+    auto t1 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d_init = t1 - t0;
+
+    random_moves<capacity> rand(_solver::n_base, seed);
+    std::vector<typename _solver::t_cube> cubes{};
+    std::vector<typename _solver::t_state> states{};
+    for (u64 i = 0; i < n_cube; i++) {
+        typename _solver::t_cube a = moves_to_cube<_solver, capacity>(rand(rand_n_moves));
+        cubes.push_back(a);
+        states.push_back(s.cube_to_state(a));
+    }
+
+    u64 distance_sum = 0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (const typename _solver::t_state &a: states) {
+        auto[d, h] = get_distance<_solver>::call(s, a);
+        distance_sum += d;
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d_lookup = t3 - t2;
+
+    u64 n_solved = 0;
+    for (const typename _solver::t_cube &a: cubes) {
+        auto it = s.template solve<capacity>(a, max_n_moves);
+        while (true) {
+            auto[f, moves] = it();
+            if (f & flag::solution) {
+                n_solved++;
+                break;
+            } else if (f & flag::end) {
+                break;
+            }
+        }
+    }
+    auto t4 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d_search = t4 - t3;
+
+    std::cout << "benchmark: solver=" << name << ", table_memory=" << _solver::table_memory()
+              << ", init=" << d_init.count() << "s, get_distance=" << d_lookup.count() / double(n_cube) * 1e9
+              << "ns, distance_sum=" << distance_sum << ", search=" << d_search.count() << "s, n_solved=" << n_solved
+              << std::endl;
+}
+
+//  time of get_distance_hint on the neighbors of random states, reading the frozen_u2 of the solver,
+//  and reading a copy of the same words in an array_u2 with atomic loads as the search did before
+template<typename _solver, u64 capacity>
+void benchmark_hint(const std::string &name, u64 n_thread, u64 seed, u64 n_cube, u64 rand_n_moves, u64 n_round) {
+    _solver s(n_thread);
+    random_moves<capacity> rand(_solver::n_base, seed);
+    std::vector<std::tuple<typename _solver::t_state, typename _solver::t_hint>> queries{};
+    for (u64 i = 0; i < n_cube; i++) {
+        typename _solver::t_state a = s.cube_to_state(moves_to_cube<_solver, capacity>(rand(rand_n_moves)));
+        auto[d, h] = get_distance<_solver>::call(s, a);
+        for (const typename _solver::t_state &b: s.adj(a)) {
+            queries.emplace_back(b, h);
+        }
+    }
+    std::shared_ptr<array_u2<_solver::n_state>> atomic_m3 = cache_alloc<array_u2<_solver::n_state>>();
+    for (u64 i = 0; i < atomic_m3->a.size(); i++) {
+        atomic_m3->a[i].store(s.distance_m3->a[i], std::memory_order_relaxed);
+    }
+
+    u64 sum_frozen = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (u64 r = 0; r < n_round; r++) {
+        for (const auto &[b, h]: queries) {
+            sum_frozen += std::get<0>(get_distance_hint<_solver>::call(s, b, h));
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    u64 sum_atomic = 0;
+    for (u64 r = 0; r < n_round; r++) {
+        for (const auto &[b, h]: queries) {
+            sum_atomic += computer_distance(atomic_m3->get(s.state_to_int(b)), h);
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d_frozen = t1 - t0;
+    std::chrono::duration<double> d_atomic = t2 - t1;
+    double n = double(queries.size() * n_round);
+
+    std::cout << "benchmark: solver=" << name << ", n_query=" << queries.size() * n_round
+              << ", get_distance_hint=" << d_frozen.count() / n * 1e9
+              << "ns, get_distance_hint_atomic=" << d_atomic.count() / n * 1e9
+              << "ns, same=" << (sum_frozen == sum_atomic) << std::endl;
+}
+
+void benchmark(const std::string &tables, u64 n_thread, u64 seed, u64 n_cube, u64 rand_n_moves, u64 max_n_moves,
+               u64 n_round) {
+    constexpr u64 capacity = 20;
+    std::map<std::string, std::function<void()>> all{
+            {"cube2", [&]() -> void {
+                benchmark_one<cube2_solver, capacity>("cube2", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+                benchmark_hint<cube2_solver, capacity>("cube2", n_thread, seed, n_cube, rand_n_moves, n_round);
+                benchmark_one<cube2_exact_solver, capacity>(
+                        "cube2_exact", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+            }},
+            {"p0s",   [&]() -> void {
+                benchmark_one<p0s_solver, capacity>("p0s", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+                benchmark_hint<p0s_solver, capacity>("p0s", n_thread, seed, n_cube, rand_n_moves, n_round);
+                benchmark_one<p0s_exact_solver, capacity>(
+                        "p0s_exact", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+            }},
+            {"c8",    [&]() -> void {
+                benchmark_one<c8_solver, capacity>("c8", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+                benchmark_hint<c8_solver, capacity>("c8", n_thread, seed, n_cube, rand_n_moves, n_round);
+                benchmark_one<c8_exact_solver, capacity>(
+                        "c8_exact", n_thread, seed, n_cube, rand_n_moves, max_n_moves);
+            }}
+    };
+    std::stringstream ss(tables);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        auto it = all.find(name);
+        if (it == all.end()) {
+            std::cout << "error tables: " << name << std::endl;
+            exit(1);
+        }
+        it->second();
+    }
+}
+
+void parse_arg(
+        int argc, char **argv,
+        std::string &tables, u64 &n_thread, u64 &seed, u64 &n_cube, u64 &rand_n_moves, u64 &max_n_moves,
+        u64 &n_round) {
+    std::tuple<u64, u64> n_thread_t = {1, 256};
+    std::tuple<u64, u64> rand_n_moves_t = {0, 20};
+    std::tuple<u64, u64> max_n_moves_t = {0, 20};
+
+    cxxopts::Options option(
+            argv[0], "Compare the distance tables modulo 3 with the exact distance tables, and time get_distance_hint");
+    option.add_options()
+            ("tables", "some of (cube2,p0s,c8)", cxxopts::value<std::string>(tables)->default_value("cube2,p0s,c8"))
+            ("n_thread", "1~256", cxxopts::value<u64>(n_thread)->default_value("4"))
+            ("seed", "0~max", cxxopts::value<u64>(seed)->default_value("0"))
+            ("n_cube", "1~max", cxxopts::value<u64>(n_cube)->default_value("1000"))
+            ("rand_n_moves", "0~20", cxxopts::value<u64>(rand_n_moves)->default_value("20"))
+            ("max_n_moves", "0~20", cxxopts::value<u64>(max_n_moves)->default_value("14"))
+            ("n_round", "1~max, rounds over the queries of get_distance_hint",
+             cxxopts::value<u64>(n_round)->default_value("100"))
+            ("help", "show help");
+
+    try {
+        cxxopts::ParseResult result = option.parse(argc, argv);
+        if (result.count("help") > 0) {
+            std::cout << option.help() << std::endl;
+            exit(0);
+        }
+    } catch (const cxxopts::OptionException &e) {
+        std::cout << "error option: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    if (n_thread < std::get<0>(n_thread_t) or n_thread > std::get<1>(n_thread_t)) {
+        std::cout << "error n_thread: " << n_thread << std::endl;
+        exit(1);
+    }
+
+    if (n_cube == 0) {
+        std::cout << "error n_cube: " << n_cube << std::endl;
+        exit(1);
+    }
+
+    if (n_round == 0) {
+        std::cout << "error n_round: " << n_round << std::endl;
+        exit(1);
+    }
+
+    if (rand_n_moves < std::get<0>(rand_n_moves_t) or rand_n_moves > std::get<1>(rand_n_moves_t)) {
+        std::cout << "error rand_n_moves: " << rand_n_moves << std::endl;
+        exit(1);
+    }
+
+    if (max_n_moves < std::get<0>(max_n_moves_t) or max_n_moves > std::get<1>(max_n_moves_t)) {
+        std::cout << "error max_n_moves: " << max_n_moves << std::endl;
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string tables;
+    u64 n_thread;
+    u64 seed;
+    u64 n_cube;
+    u64 rand_n_moves;
+    u64 max_n_moves;
+    u64 n_round;
+
+    parse_arg(argc, argv, tables, n_thread, seed, n_cube, rand_n_moves, max_n_moves, n_round);
+
+    cache_options.n_stream = n_thread;
+
+    try {
+        benchmark(tables, n_thread, seed, n_cube, rand_n_moves, max_n_moves, n_round);
+    } catch (const std::runtime_error &e) {
+        std::cout << "error cache: " << e.what() << std::endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,1764 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+#include <fcntl.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "codec.h"
+
+//  cache file format, version 2
+//
+//  header     magic, version, number of sections, header size, header checksum
+//  sections   name, type name, sizeof(T), element counts, offset, size, sha256 of table, codec, chunk size
+//  payloads   one per section, each starts at a multiple of cache_align
+//
+//  a payload is the table itself, or with a codec, the end offsets of the chunks followed by the chunks,
+//  each chunk_size bytes of the table compressed on its own, version 1 files have no codec
+//
+//  a file may hold several sections, "cache/cube3.p0sy" can bundle all "cube3.p0sy.*" tables
+
+namespace cube {
+    //  tables are read only once they are loaded or computed,
+    //  so they are shared as pointer to const
+    template<typename T>
+    using cache_ptr = std::shared_ptr<const T>;
+
+    //  bytes of the tables behind some cache_ptr members, for the table_memory of a solver
+    template<typename... P>
+    constexpr u64 cache_size() {
+        return (sizeof(typename P::element_type) + ...);
+    }
+
+    struct cache_option {
+        //  map the cache files read only instead of copying them into anonymous memory,
+        //  the pages are shared through the page cache with other processes
+        bool mmap = false;
+
+        //  number of threads reading one cache file
+        u64 n_stream = 1;
+
+        //  read with O_DIRECT, bypassing the page cache
+        bool direct = false;
+
+        //  share the tables with other processes through a segment in /dev/shm
+        bool shm = false;
+
+        //  back tables with huge pages, "none", "thp", "2m" or "1g",
+        //  "2m" and "1g" fall back to smaller pages if the hugetlb pool is empty
+        std::string huge_page = "none";
+
+        //  compress the cache files written
+        bool compress = false;
+
+        //  check the sha256 of tables read against the manifest, "none", "rebuild" or "refuse",
+        //  a table which does not match is computed again or stops the program
+        std::string verify = "none";
+
+        //  reference checksums, lines of "<sha256>  <table name>"
+        std::string manifest = "sha256.txt";
+
+        //  seconds between checkpoints of a bfs building a table, 0 for none
+        u64 checkpoint = 600;
+
+        //  bytes of memory a bfs may use for its table, a larger table is built on disk in "cache/<name>.bfs/",
+        //  0 for no limit
+        u64 bfs_memory = 0;
+
+        //  how a bfs in memory sets the states of a depth, "cas" or "partition"
+        std::string bfs_strategy = "cas";
+
+        //  append JSON lines of the work of each depth and thread of a bfs to "cache/<name>.bfs.jsonl"
+        bool bfs_telemetry = false;
+
+        //  seconds between the progress lines within a depth of a bfs, with its eta, 0 for none
+        u64 bfs_progress = 60;
+
+        //  time a sample of the chunks both forward and backward once the unset states are near the frontier in number,
+        //  to choose between them before backward ran
+        bool bfs_sample = true;
+
+        //  place the tables on the numa nodes, "none", "interleave" the pages of each table across the nodes,
+        //  or "replicate" the tables the search reads most on each node, for search threads pinned to the node
+        std::string numa = "none";
+    };
+
+    inline cache_option cache_options{};
+
+    constexpr u64 cache_magic = 0x31454843'41434243;  // "CBCACHE1"
+    constexpr u32 cache_version = 2;
+    constexpr u64 cache_align = 4096;
+    constexpr u64 cache_chunk_size = u64(1) << 26;
+    constexpr u64 cache_codec_none = 0;
+    constexpr u64 cache_codec_huffman = 1;
+    constexpr u64 cache_codec_chunk_size = u64(1) << 22;
+
+    struct sha256 {
+        static constexpr std::array<u32, 64> k{
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        std::array<u32, 8> h{
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        std::array<u8, 64> buf{};
+        u64 n_buf = 0;
+        u64 n_total = 0;
+
+        static constexpr u32 rotr(u32 x, u64 n) {
+            return (x >> n) | (x << (32 - n));
+        }
+
+        void block(const u8 *p) {
+            std::array<u32, 64> w{};
+            for (u64 i = 0; i < 16; i++) {
+                w[i] = (u32(p[i * 4]) << 24) | (u32(p[i * 4 + 1]) << 16) | (u32(p[i * 4 + 2]) << 8) | u32(p[i * 4 + 3]);
+            }
+            for (u64 i = 16; i < 64; i++) {
+                u32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                u32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            //  the working variables are locals so they stay in registers
+            u32 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+            for (u64 i = 0; i < 64; i++) {
+                u32 s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                u32 ch = (e & f) ^ (~e & g);
+                u32 t1 = hh + s1 + ch + k[i] + w[i];
+                u32 s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                u32 maj = (a & b) ^ (a & c) ^ (b & c);
+                u32 t2 = s0 + maj;
+                hh = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+            h[5] += f;
+            h[6] += g;
+            h[7] += hh;
+        }
+
+#if defined(__x86_64__)
+        static bool has_sha_ni() {
+            static const bool has = []() -> bool {
+                unsigned a, b, c, d;
+                if (not __get_cpuid(1, &a, &b, &c, &d) or not (c & bit_SSE4_1)) {
+                    return false;
+                }
+                return __get_cpuid_count(7, 0, &a, &b, &c, &d) and (b & (1u << 29));
+            }();
+            return has;
+        }
+
+        //  the SHA extensions of x86, four rounds per step with the message schedule kept in 4 registers
+        __attribute__((target("sha,sse4.1,ssse3")))
+        static void blocks_sha_ni(std::array<u32, 8> &h, const u8 *p, u64 n) {
+            const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0b, 0x0405060700010203);
+            __m128i t = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&h[0])), 0xb1);
+            __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&h[4])), 0x1b);
+            __m128i s0 = _mm_alignr_epi8(t, s1, 8);
+            s1 = _mm_blend_epi16(s1, t, 0xf0);
+            for (; n > 0; n--, p += 64) {
+                __m128i s0_save = s0;
+                __m128i s1_save = s1;
+                __m128i w[4];
+                for (u64 i = 0; i < 16; i++) {
+                    __m128i m;
+                    if (i < 4) {
+                        m = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 16)), mask);
+                    } else {
+                        m = _mm_sha256msg1_epu32(w[i % 4], w[(i + 1) % 4]);
+                        m = _mm_add_epi32(m, _mm_alignr_epi8(w[(i + 3) % 4], w[(i + 2) % 4], 4));
+                        m = _mm_sha256msg2_epu32(m, w[(i + 3) % 4]);
+                    }
+                    w[i % 4] = m;
+                    __m128i x = _mm_add_epi32(m, _mm_loadu_si128(reinterpret_cast<const __m128i *>(&k[i * 4])));
+                    s1 = _mm_sha256rnds2_epu32(s1, s0, x);
+                    s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(x, 0x0e));
+                }
+                s0 = _mm_add_epi32(s0, s0_save);
+                s1 = _mm_add_epi32(s1, s1_save);
+            }
+            t = _mm_shuffle_epi32(s0, 0x1b);
+            s1 = _mm_shuffle_epi32(s1, 0xb1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&h[0]), _mm_blend_epi16(t, s1, 0xf0));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&h[4]), _mm_alignr_epi8(s1, t, 8));
+        }
+#endif
+
+        void blocks(const u8 *p, u64 n) {
+#if defined(__x86_64__)
+            if (has_sha_ni()) {
+                blocks_sha_ni(h, p, n);
+                return;
+            }
+#endif
+            for (; n > 0; n--, p += 64) {
+                block(p);
+            }
+        }
+
+        void update(const void *data, u64 n) {
+            const u8 *p = reinterpret_cast<const u8 *>(data);
+            n_total += n;
+            if (n_buf > 0) {
+                u64 m = std::min(n, 64 - n_buf);
+                std::memcpy(&buf[n_buf], p, m);
+                n_buf += m;
+                p += m;
+                n -= m;
+                if (n_buf < 64) {
+                    return;
+                }
+                blocks(&buf[0], 1);
+                n_buf = 0;
+            }
+            blocks(p, n / 64);
+            p += n / 64 * 64;
+            n %= 64;
+            std::memcpy(&buf[0], p, n);
+            n_buf = n;
+        }
+
+        std::array<u8, 32> digest() {
+            u64 n_bit = n_total * 8;
+            u8 pad = 0x80;
+            update(&pad, 1);
+            pad = 0;
+            while (n_buf != 56) {
+                update(&pad, 1);
+            }
+            std::array<u8, 8> len{};
+            for (u64 i = 0; i < 8; i++) {
+                len[i] = u8(n_bit >> (56 - i * 8));
+            }
+            update(&len[0], 8);
+            std::array<u8, 32> d{};
+            for (u64 i = 0; i < 32; i++) {
+                d[i] = u8(h[i / 4] >> (24 - i % 4 * 8));
+            }
+            return d;
+        }
+
+        static std::string to_string(const std::array<u8, 32> &d) {
+            static constexpr char hex[] = "0123456789abcdef";
+            std::string s{};
+            for (u8 x: d) {
+                s += hex[x >> 4];
+                s += hex[x & 15];
+            }
+            return s;
+        }
+    };
+
+    struct _cache_file_header {
+        u64 magic;
+        u32 version;
+        u32 n_section;
+        u64 header_size;
+        u64 checksum;
+    };
+
+    struct _cache_file_section {
+        std::array<char, 64> name;
+        std::array<char, 96> type;
+        u64 type_size;
+        u64 n_shape;
+        std::array<u64, 8> shape;
+        u64 offset;
+        u64 size;
+        std::array<u8, 32> sha256;
+        u64 codec;
+        u64 chunk_size;
+    };
+
+    struct cache_section {
+        std::string name;
+        std::string type;
+        u64 type_size;
+        std::vector<u64> shape;
+        u64 offset;
+        u64 size;
+        std::array<u8, 32> sha256;
+        u64 codec;
+        u64 chunk_size;
+        const void *data;
+    };
+
+    template<typename T>
+    cache_section make_cache_section(const std::string &name, const T &data) {
+        return cache_section{
+                name, type_desc<T>::name(), sizeof(T), type_desc<T>::shape(), 0, sizeof(T), {},
+                cache_options.compress ? cache_codec_huffman : cache_codec_none, cache_codec_chunk_size, &data
+        };
+    }
+
+    constexpr u64 _cache_round_up(u64 x) {
+        return (x + cache_align - 1) / cache_align * cache_align;
+    }
+
+    inline u64 _cache_checksum(const std::vector<u8> &header) {
+        //  FNV-1a over the header with the checksum field cleared
+        u64 h = 0xcbf29ce484222325;
+        for (u64 i = 0; i < header.size(); i++) {
+            u8 x = (i >= offsetof(_cache_file_header, checksum) and i < sizeof(_cache_file_header)) ? 0 : header[i];
+            h = (h ^ x) * 0x100000001b3;
+        }
+        return h;
+    }
+
+    template<u64 n>
+    std::array<char, n> _cache_string(const std::string &s) {
+        std::array<char, n> a{};
+        std::memcpy(&a[0], s.data(), std::min(s.size(), n - 1));
+        return a;
+    }
+
+    template<u64 n>
+    std::string _cache_string(const std::array<char, n> &a) {
+        return std::string(&a[0], strnlen(&a[0], n));
+    }
+
+    //  the type name of T as it is stored in a cache file or a shm segment, cut to the field
+    template<typename T>
+    std::string cache_type_name() {
+        return _cache_string(_cache_string<96>(type_desc<T>::name()));
+    }
+
+    //  read and check the header of a cache file, only the header is read
+    inline std::tuple<bool, std::string, std::vector<cache_section>> read_cache_header(const std::string &path) {
+        std::ifstream f{path, std::ios::binary};
+        if (not f) {
+            return {false, "cannot open", {}};
+        }
+        u64 file_size = std::filesystem::file_size(path);
+        _cache_file_header h{};
+        f.read(reinterpret_cast<char *>(&h), sizeof(h));
+        if (not f or h.magic != cache_magic) {
+            return {false, "bad magic", {}};
+        }
+        if (h.version != 1 and h.version != cache_version) {
+            return {false, "bad version " + std::to_string(h.version), {}};
+        }
+        //  version 1 sections end before the codec
+        u64 section_size = h.version == 1 ? offsetof(_cache_file_section, codec) : sizeof(_cache_file_section);
+        u64 table_size = sizeof(h) + h.n_section * section_size;
+        if (h.n_section == 0 or h.n_section > 1024 or h.header_size != _cache_round_up(table_size)
+            or h.header_size > file_size) {
+            return {false, "bad header size", {}};
+        }
+        std::vector<u8> header(table_size);
+        f.seekg(0);
+        f.read(reinterpret_cast<char *>(&header[0]), table_size);
+        if (not f or _cache_checksum(header) != h.checksum) {
+            return {false, "bad header checksum", {}};
+        }
+        std::vector<cache_section> sections{};
+        for (u64 i = 0; i < h.n_section; i++) {
+            _cache_file_section s{};
+            std::memcpy(&s, &header[sizeof(h) + i * section_size], section_size);
+            if (s.n_shape > s.shape.size() or s.offset % cache_align != 0 or s.offset < h.header_size
+                or s.offset + s.size > file_size) {
+                return {false, "bad section " + std::to_string(i), {}};
+            }
+            if (s.codec != cache_codec_none and (s.codec != cache_codec_huffman or s.chunk_size == 0)) {
+                return {false, "bad codec " + std::to_string(s.codec), {}};
+            }
+            sections.push_back(cache_section{
+                    _cache_string(s.name), _cache_string(s.type), s.type_size,
+                    std::vector<u64>(s.shape.begin(), s.shape.begin() + s.n_shape),
+                    s.offset, s.size, s.sha256, s.codec, s.chunk_size, nullptr
+            });
+        }
+        return {true, "", sections};
+    }
+
+    //  compress the table in chunks on n_thread threads
+    inline std::vector<u8> _cache_compress(const void *data, u64 size, u64 chunk_size, u64 n_thread) {
+        const u8 *p = reinterpret_cast<const u8 *>(data);
+        u64 n_chunk = (size + chunk_size - 1) / chunk_size;
+        std::vector<std::vector<u8>> chunks(n_chunk);
+        std::atomic<u64> next{0};
+        std::vector<std::future<void>> future{};
+        for (u64 t = 0; t < std::max(n_thread, u64(1)); t++) {
+            future.push_back(std::async(std::launch::async, [&]() -> void {
+                for (u64 i = next++; i < n_chunk; i = next++) {
+                    u64 start = i * chunk_size;
+                    chunks[i] = huffman_codec::compress(p + start, std::min(chunk_size, size - start));
+                }
+            }));
+        }
+        for (std::future<void> &f: future) {
+            f.get();
+        }
+        std::vector<u8> payload(n_chunk * sizeof(u64));
+        for (u64 i = 0; i < n_chunk; i++) {
+            payload.insert(payload.end(), chunks[i].begin(), chunks[i].end());
+            u64 end = payload.size();
+            std::memcpy(&payload[i * sizeof(u64)], &end, sizeof(u64));
+            std::vector<u8>().swap(chunks[i]);
+        }
+        return payload;
+    }
+
+    constexpr u64 _cache_header_size(u64 n_section) {
+        return _cache_round_up(sizeof(_cache_file_header) + n_section * sizeof(_cache_file_section));
+    }
+
+    //  the header of a file with the sections, their offsets, sizes and hashes are set
+    inline std::vector<u8> _cache_header(const std::vector<cache_section> &sections) {
+        _cache_file_header h{cache_magic, cache_version, u32(sections.size()), 0, 0};
+        u64 table_size = sizeof(h) + sections.size() * sizeof(_cache_file_section);
+        h.header_size = _cache_header_size(sections.size());
+        std::vector<u8> header(h.header_size, 0);
+        for (u64 i = 0; i < sections.size(); i++) {
+            const cache_section &s = sections[i];
+            _cache_file_section fs{
+                    _cache_string<64>(s.name), _cache_string<96>(s.type), s.type_size, s.shape.size(), {},
+                    s.offset, s.size, s.sha256, s.codec, s.codec == cache_codec_none ? 0 : s.chunk_size
+            };
+            std::copy(s.shape.begin(), s.shape.end(), fs.shape.begin());
+            std::memcpy(&header[sizeof(h) + i * sizeof(fs)], &fs, sizeof(fs));
+        }
+        std::memcpy(&header[0], &h, sizeof(h));
+        h.checksum = _cache_checksum(std::vector<u8>(header.begin(), header.begin() + table_size));
+        std::memcpy(&header[0], &h, sizeof(h));
+        return header;
+    }
+
+    //  other processes may have the old file mapped, it is replaced instead of truncated,
+    //  the temporary file is named by process and thread, so concurrent writers of a table do not share it
+    inline std::string _cache_tmp_path(const std::string &path) {
+        return path + ".tmp." + std::to_string(getpid()) + "."
+               + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    }
+
+    //  write the sections into one file, the tables are hashed and compressed before they are written
+    inline void write_cache_file(const std::string &path, std::vector<cache_section> &sections, u64 n_thread = 1) {
+        u64 offset = _cache_header_size(sections.size());
+        std::vector<std::vector<u8>> payloads(sections.size());
+        for (u64 i = 0; i < sections.size(); i++) {
+            cache_section &s = sections[i];
+            assert(s.shape.size() <= 8);
+            sha256 hash{};
+            hash.update(s.data, s.type_size);
+            s.sha256 = hash.digest();
+            s.size = s.type_size;
+            if (s.codec != cache_codec_none) {
+                payloads[i] = _cache_compress(s.data, s.type_size, s.chunk_size, n_thread);
+                s.size = payloads[i].size();
+            }
+            s.offset = offset;
+            offset = _cache_round_up(offset + s.size);
+        }
+        std::vector<u8> header = _cache_header(sections);
+        std::string tmp = _cache_tmp_path(path);
+        {
+            std::ofstream f{tmp, std::ios::binary};
+            f.write(reinterpret_cast<const char *>(&header[0]), header.size());
+            for (u64 i = 0; i < sections.size(); i++) {
+                const cache_section &s = sections[i];
+                std::vector<char> pad(s.offset - u64(f.tellp()), 0);
+                f.write(pad.data(), pad.size());
+                const void *payload = s.codec == cache_codec_none ? s.data : payloads[i].data();
+                f.write(reinterpret_cast<const char *>(payload), s.size);
+            }
+        }
+        std::filesystem::rename(tmp, path);
+    }
+
+    //  find the section of a table, either in its own file or in a bundle named by a prefix of its name
+    template<typename T>
+    std::tuple<bool, std::string, std::string, cache_section> _cache_find(
+            const std::string &dir, const std::string &name) {
+        std::vector<std::string> paths{dir + name};
+        for (u64 i = name.rfind('.'); i != std::string::npos and i > 0; i = name.rfind('.', i - 1)) {
+            paths.push_back(dir + name.substr(0, i));
+        }
+        for (const std::string &path: paths) {
+            if (not std::filesystem::exists(path)) {
+                continue;
+            }
+            auto[ok, error, sections] = read_cache_header(path);
+            if (not ok and path == paths[0] and error == "bad magic"
+                and std::filesystem::file_size(path) == sizeof(T)) {
+                //  raw dump written before the cache file format existed
+                return {true, "legacy", path, cache_section{
+                        name, "", sizeof(T), {}, 0, sizeof(T), {}, cache_codec_none, 0, nullptr
+                }};
+            }
+            if (not ok) {
+                return {false, error, path, {}};
+            }
+            for (const cache_section &s: sections) {
+                if (s.name != name) {
+                    continue;
+                }
+                if (s.type != cache_type_name<T>()) {
+                    return {false, "bad type " + s.type, path, s};
+                }
+                if (s.type_size != sizeof(T) or (s.codec == cache_codec_none and s.size != sizeof(T))) {
+                    return {false, "bad size " + std::to_string(s.type_size), path, s};
+                }
+                if (s.shape != type_desc<T>::shape()) {
+                    return {false, "bad shape " + vector_to_string<u64>(s.shape), path, s};
+                }
+                return {true, "", path, s};
+            }
+        }
+        return {false, "not found", "", {}};
+    }
+
+    template<typename T>
+    cache_ptr<T> _cache_map(const std::string &path, u64 offset) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        u64 page = sysconf(_SC_PAGESIZE);
+        u64 skip = offset % page;
+        void *p = mmap(nullptr, skip + sizeof(T), PROT_READ, MAP_SHARED, fd, off_t(offset - skip));
+        close(fd);
+        if (p == MAP_FAILED) {
+            return nullptr;
+        }
+        return cache_ptr<T>(reinterpret_cast<const T *>(reinterpret_cast<const u8 *>(p) + skip),
+                            [p, skip](const T *) -> void {
+                                munmap(p, skip + sizeof(T));
+                            });
+    }
+
+    //  tables live in page aligned anonymous memory, which O_DIRECT reads require
+    inline void *_cache_alloc_pages(u64 size, u64 page_shift) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        if (page_shift > 12) {
+            flags |= MAP_HUGETLB | int(page_shift << MAP_HUGE_SHIFT);
+        }
+#else
+        if (page_shift > 12) {
+            return nullptr;
+        }
+#endif
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    struct numa_node {
+        u64 id;
+        std::vector<u64> cpus;
+    };
+
+    //  the numa nodes by id, from /sys/devices/system/node, whose ids may have gaps,
+    //  one node 0 of all cpus where it is not available, the node arguments below index this
+    inline const std::vector<numa_node> &numa_nodes() {
+        static const std::vector<numa_node> nodes = []() -> std::vector<numa_node> {
+            std::vector<numa_node> r{};
+            std::error_code ec;
+            for (const auto &entry: std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+                std::string dir = entry.path().filename().string();
+                unsigned long id = 0;
+                int n_read = 0;
+                if (sscanf(dir.c_str(), "node%lu%n", &id, &n_read) != 1 or n_read != int(dir.size())) {
+                    continue;
+                }
+                std::ifstream f(entry.path() / "cpulist");
+                if (not f) {
+                    continue;
+                }
+                std::string list;
+                std::getline(f, list);
+                std::vector<u64> cpus{};
+                std::stringstream ss(list);
+                std::string range;
+                while (std::getline(ss, range, ',')) {
+                    unsigned long start = 0, end = 0;
+                    int n = sscanf(range.c_str(), "%lu-%lu", &start, &end);
+                    if (n == 1) {
+                        end = start;
+                    }
+                    for (u64 c = start; n >= 1 and c <= end; c++) {
+                        cpus.push_back(c);
+                    }
+                }
+                r.push_back({id, cpus});
+            }
+            std::sort(r.begin(), r.end(), [](const numa_node &a, const numa_node &b) -> bool {
+                return a.id < b.id;
+            });
+            if (r.empty()) {
+                std::vector<u64> cpus(std::max(std::thread::hardware_concurrency(), 1u));
+                std::iota(cpus.begin(), cpus.end(), 0);
+                r.push_back({0, cpus});
+            }
+            return r;
+        }();
+        return nodes;
+    }
+
+    constexpr int _mpol_bind = 2;
+    constexpr int _mpol_interleave = 3;
+
+    //  sets the numa policy of the pages of [p, p + size) not touched yet, mode is _mpol_bind or _mpol_interleave,
+    //  false where it is not supported
+    inline bool _numa_mbind(void *p, u64 size, int mode, const std::vector<u64> &nodes) {
+#if defined(__linux__) && defined(SYS_mbind)
+        std::vector<unsigned long> mask(1024 / 64, 0);
+        for (u64 n: nodes) {
+            mask[n / 64] |= 1ul << (n % 64);
+        }
+        return syscall(SYS_mbind, p, size, mode, mask.data(), mask.size() * 64, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+    //  pins the calling thread to the cpus of a numa node
+    inline bool numa_pin(u64 node) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (u64 c: numa_nodes()[node].cpus) {
+            CPU_SET(c, &set);
+        }
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    //  with a node the pages are taken from it, otherwise with cache_options.numa "interleave" they are spread
+    //  over all nodes, the policy is set before any page is touched
+    template<typename T>
+    std::shared_ptr<T> cache_alloc(u64 node = u64(-1)) {
+        const std::string &huge_page = cache_options.huge_page;
+        std::vector<u64> page_shift{};
+        if (huge_page == "1g") {
+            page_shift.push_back(30);
+        }
+        if (huge_page == "1g" or huge_page == "2m") {
+            page_shift.push_back(21);
+        }
+        page_shift.push_back(12);
+
+        u64 size = 0;
+        void *p = nullptr;
+        for (u64 shift: page_shift) {
+            if (sizeof(T) >= (u64(1) << shift) or shift == 12) {
+                size = (sizeof(T) + (u64(1) << shift) - 1) >> shift << shift;
+                p = _cache_alloc_pages(size, shift);
+                if (p != nullptr) {
+                    break;
+                }
+            }
+        }
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge_page != "none" and sizeof(T) >= (u64(1) << 21)) {
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+#endif
+        if (node != u64(-1)) {
+            _numa_mbind(p, size, _mpol_bind, {numa_nodes()[node].id});
+        } else if (cache_options.numa == "interleave" and numa_nodes().size() > 1) {
+            std::vector<u64> all{};
+            for (const numa_node &n: numa_nodes()) {
+                all.push_back(n.id);
+            }
+            _numa_mbind(p, size, _mpol_interleave, all);
+        }
+        return std::shared_ptr<T>(new(p) T, [size](T *q) -> void {
+            munmap(q, size);
+        });
+    }
+
+    //  page size of the mapping holding p and the bytes of it backed by huge pages,
+    //  read from /proc/self/smaps, zero where it is not available
+    inline std::tuple<u64, u64> cache_huge_page_usage(const void *p) {
+        std::ifstream f("/proc/self/smaps");
+        u64 x = u64(p);
+        bool in = false;
+        u64 page_size = 0;
+        u64 huge = 0;
+        std::string line;
+        while (std::getline(f, line)) {
+            unsigned long start = 0, end = 0;
+            if (sscanf(line.c_str(), "%lx-%lx", &start, &end) == 2) {
+                if (in) {
+                    break;
+                }
+                in = start <= x and x < end;
+                continue;
+            }
+            if (not in) {
+                continue;
+            }
+            unsigned long kb = 0;
+            char key[64] = {};
+            if (sscanf(line.c_str(), "%63[^:]: %lu kB", key, &kb) == 2) {
+                std::string k = key;
+                if (k == "KernelPageSize") {
+                    page_size = u64(kb) << 10;
+                } else if (k == "AnonHugePages" or k == "Private_Hugetlb" or k == "Shared_Hugetlb") {
+                    huge += u64(kb) << 10;
+                }
+            }
+        }
+        return {page_size, huge};
+    }
+
+    inline int _open_direct(const std::string &path) {
+#ifdef O_DIRECT
+        return open(path.c_str(), O_RDONLY | O_DIRECT);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fcntl(fd, F_NOCACHE, 1);
+        }
+        return fd;
+#endif
+    }
+
+    inline bool _read_chunks(
+            int fd, u64 offset, u64 size, u64 read_size, u8 *p, u64 chunk_size, std::atomic<u64> &next,
+            const std::function<void(u64, u64)> &on_read) {
+        for (u64 i = next++; i * chunk_size < read_size; i = next++) {
+            u64 start = i * chunk_size;
+            u64 end = std::min(start + chunk_size, read_size);
+            for (u64 pos = start; pos < std::min(end, size);) {
+                ssize_t n = pread(fd, p + pos, end - pos, off_t(offset + pos));
+                if (n <= 0) {
+                    return false;
+                }
+                pos += n;
+            }
+            if (on_read and start < size) {
+                on_read(start, std::min(end, size));
+            }
+        }
+        return true;
+    }
+
+    //  read size bytes at offset of a file with n_stream threads using positioned reads,
+    //  the threads take chunks in turn, with direct the chunks are read with O_DIRECT
+    //  and p must have room for size rounded up to cache_align,
+    //  on_read is called with the byte range of each chunk read
+    inline std::tuple<bool, bool> read_parallel(
+            const std::string &path, u64 offset, u64 size, void *p, u64 n_stream, bool direct,
+            const std::function<void(u64, u64)> &on_read = nullptr) {
+        int fd = -1;
+        if (direct and offset % cache_align == 0 and reinterpret_cast<uintptr_t>(p) % cache_align == 0) {
+            fd = _open_direct(path);
+        }
+        u64 read_size = size;
+        if (fd >= 0) {
+            read_size = _cache_round_up(size);
+        } else {
+            direct = false;
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                return {false, false};
+            }
+        }
+        u64 chunk_size = std::min(cache_chunk_size, _cache_round_up((read_size + n_stream - 1) / n_stream));
+        std::atomic<u64> next{0};
+        std::vector<std::future<bool>> result{};
+        for (u64 i = 0; i < n_stream; i++) {
+            result.push_back(std::async(
+                    std::launch::async,
+                    &_read_chunks,
+                    fd, offset, size, read_size, reinterpret_cast<u8 *>(p), chunk_size, std::ref(next),
+                    std::cref(on_read)));
+        }
+        bool ok = true;
+        for (u64 i = 0; i < n_stream; i++) {
+            ok = result[i].get() and ok;
+        }
+        close(fd);
+        return {ok, direct};
+    }
+
+    inline bool _pread_all(int fd, void *p, u64 size, u64 offset) {
+        u8 *q = reinterpret_cast<u8 *>(p);
+        for (u64 start = 0; start < size;) {
+            ssize_t n = pread(fd, q + start, size - start, off_t(offset + start));
+            if (n <= 0) {
+                return false;
+            }
+            start += u64(n);
+        }
+        return true;
+    }
+
+    //  n_stream threads take the chunks in turn, each reads a compressed chunk and decodes it
+    //  straight into its place in the table, so reading and decoding overlap across threads
+    inline bool read_compressed(const std::string &path, const cache_section &section, void *p, u64 n_stream,
+                                const std::function<void(u64, u64)> &on_read = nullptr) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        u64 n_chunk = (section.type_size + section.chunk_size - 1) / section.chunk_size;
+        std::vector<u64> end(n_chunk);
+        bool ok = n_chunk * sizeof(u64) <= section.size
+                  and _pread_all(fd, end.data(), n_chunk * sizeof(u64), section.offset);
+        for (u64 i = 0; ok and i < n_chunk; i++) {
+            u64 begin = i == 0 ? n_chunk * sizeof(u64) : end[i - 1];
+            ok = begin <= end[i] and end[i] <= section.size;
+        }
+        if (not ok) {
+            close(fd);
+            return false;
+        }
+        std::atomic<u64> next{0};
+        std::vector<std::future<bool>> result{};
+        for (u64 t = 0; t < std::max(n_stream, u64(1)); t++) {
+            result.push_back(std::async(std::launch::async, [&]() -> bool {
+                std::vector<u8> buf{};
+                for (u64 i = next++; i < n_chunk; i = next++) {
+                    u64 begin = i == 0 ? n_chunk * sizeof(u64) : end[i - 1];
+                    u64 start = i * section.chunk_size;
+                    u64 size = std::min(section.chunk_size, section.type_size - start);
+                    buf.resize(end[i] - begin);
+                    if (not _pread_all(fd, buf.data(), buf.size(), section.offset + begin)
+                        or not huffman_codec::decompress(
+                            buf.data(), buf.size(), reinterpret_cast<u8 *>(p) + start, size)) {
+                        next = n_chunk;
+                        return false;
+                    }
+                    if (on_read) {
+                        on_read(start, start + size);
+                    }
+                }
+                return true;
+            }));
+        }
+        for (std::future<bool> &r: result) {
+            ok = r.get() and ok;
+        }
+        close(fd);
+        return ok;
+    }
+
+    //  read the table of a section into p, returns whether it succeeded and whether O_DIRECT was used
+    inline std::tuple<bool, bool> read_section(
+            const std::string &path, const cache_section &section, void *p, u64 n_stream, bool direct,
+            const std::function<void(u64, u64)> &on_read = nullptr) {
+        if (section.codec != cache_codec_none) {
+            return {read_compressed(path, section, p, n_stream, on_read), false};
+        }
+        auto[ok, used_direct] = read_parallel(path, section.offset, section.type_size, p, n_stream, direct, on_read);
+        if (not ok and used_direct) {
+            std::tie(ok, used_direct) = read_parallel(
+                    path, section.offset, section.type_size, p, n_stream, false, on_read);
+        }
+        return {ok, used_direct};
+    }
+
+    //  sha256 of a table computed on its own thread while the table is read,
+    //  the reading threads hand over the chunks in any order and they are hashed in order
+    struct _cache_hasher {
+        const u8 *p;
+        u64 size;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::map<u64, u64> ready;
+        bool stop = false;
+
+        _cache_hasher(const void *_p, u64 _size) : p(reinterpret_cast<const u8 *>(_p)), size(_size) {
+        }
+
+        void add(u64 start, u64 end) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready[start] = std::max(ready[start], end);
+            cv.notify_one();
+        }
+
+        void cancel() {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            cv.notify_one();
+        }
+
+        //  end of the bytes read from pos on, pos if they have not arrived,
+        //  a read retried after a failure may hand over chunks overlapping the hashed ones
+        u64 _ready_end(u64 pos) {
+            u64 end = pos;
+            for (auto it = ready.begin(); it != ready.end() and it->first <= pos; it++) {
+                end = std::max(end, it->second);
+            }
+            return end;
+        }
+
+        std::array<u8, 32> run() {
+            sha256 hash{};
+            for (u64 pos = 0; pos < size;) {
+                u64 end;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() -> bool { return stop or _ready_end(pos) > pos; });
+                    if (stop) {
+                        return {};
+                    }
+                    end = _ready_end(pos);
+                    ready.erase(ready.begin(), ready.upper_bound(pos));
+                }
+                hash.update(p + pos, end - pos);
+                pos = end;
+            }
+            return hash.digest();
+        }
+    };
+
+    //  checksums of the manifest by table name, read once
+    inline const std::map<std::string, std::string> &cache_manifest() {
+        static const std::map<std::string, std::string> manifest = []() -> std::map<std::string, std::string> {
+            std::map<std::string, std::string> m{};
+            std::ifstream f{cache_options.manifest};
+            std::string digest;
+            std::string name;
+            while (f >> digest >> name) {
+                m[name] = digest;
+            }
+            return m;
+        }();
+        return manifest;
+    }
+
+    //  the checksum a table should have, from the manifest, otherwise from the cache file
+    inline std::string _cache_expected(const std::string &name, const std::array<u8, 32> &digest) {
+        const std::map<std::string, std::string> &manifest = cache_manifest();
+        auto it = manifest.find(name);
+        if (it != manifest.end()) {
+            return it->second;
+        }
+        return digest == std::array<u8, 32>{} ? "" : sha256::to_string(digest);
+    }
+
+    //  compare the checksum of a table with the expected one,
+    //  returns "ok", "failed" or "unknown" when nothing is expected
+    inline std::string _cache_check(const std::string &name, const std::string &expected,
+                                    const std::array<u8, 32> &digest) {
+        std::string actual = sha256::to_string(digest);
+        std::string result = expected.empty() ? "unknown" : expected == actual ? "ok" : "failed";
+        std::cout << "cache_data: verify " << name << " " << result << ", sha256=" << actual;
+        if (result == "failed") {
+            std::cout << ", expected=" << expected;
+        }
+        std::cout << std::endl;
+        return result;
+    }
+
+    //  read_section, with verify the table is hashed while it is read,
+    //  returns whether it was read, whether O_DIRECT was used and the result of the verification
+    inline std::tuple<bool, bool, std::string> _cache_read_verify(
+            const std::string &name, const std::string &path, const cache_section &section,
+            void *p, u64 n_stream, bool direct) {
+        if (cache_options.verify == "none") {
+            auto[ok, used_direct] = read_section(path, section, p, n_stream, direct);
+            return {ok, used_direct, ""};
+        }
+        _cache_hasher hasher(p, section.type_size);
+        std::future<std::array<u8, 32>> digest = std::async(std::launch::async, &_cache_hasher::run, &hasher);
+        auto[ok, used_direct] = read_section(
+                path, section, p, n_stream, direct, [&hasher](u64 start, u64 end) -> void {
+                    hasher.add(start, end);
+                });
+        if (not ok) {
+            hasher.cancel();
+            digest.get();
+            return {false, used_direct, ""};
+        }
+        std::string result = _cache_check(name, _cache_expected(name, section.sha256), digest.get());
+        return {result != "failed", used_direct, result};
+    }
+
+    template<typename T>
+    std::tuple<cache_ptr<T>, std::string> _cache_read(
+            const std::string &name, const std::string &path, const cache_section &section) {
+        std::shared_ptr<T> p = cache_alloc<T>();
+        u64 n_stream = sizeof(T) >= cache_chunk_size or section.codec != cache_codec_none
+                       ? std::max(cache_options.n_stream, u64(1)) : 1;
+        auto t0 = std::chrono::steady_clock::now();
+        auto[ok, direct, verify] = _cache_read_verify(name, path, section, p.get(), n_stream, cache_options.direct);
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t1 - t0;
+        if (not ok) {
+            std::cout << "cache_data: load " << name << " failed" << std::endl;
+            return {nullptr, verify};
+        }
+        std::cout << "cache_data: load " << name << " ok, size=" << sizeof(T) << ", stored_size=" << section.size
+                  << ", n_stream=" << n_stream << ", direct=" << direct
+                  << ", time=" << d.count() << "s, speed=" << double(sizeof(T)) / d.count() / 1e9 << "GB/s"
+                  << std::endl;
+        return {p, verify};
+    }
+
+    //  shared memory segment "/dev/shm/cube_solver.<name>", a header page and the table,
+    //  a process creates, attaches to or removes a segment only under an exclusive flock of "<segment>.lock",
+    //  so the others wait on it while the first one fills the segment from the cache file,
+    //  each process holding the table keeps a shared flock of the segment while it is mapped,
+    //  the last one detaching can turn it exclusive and removes the segment,
+    //  the flocks of a process which crashed are dropped with its file descriptors
+    constexpr u64 cache_shm_magic = 0x324d4853'41434243;  // "CBCASHM2"
+
+    struct _cache_shm_header {
+        u64 magic;
+        u32 version;
+        std::atomic<u32> ready;
+        u64 type_size;
+        std::array<char, 96> type;
+        std::array<u8, 32> sha256;
+    };
+
+    inline std::string cache_shm_name(const std::string &name) {
+        return "/cube_solver." + name;
+    }
+
+    //  the exclusive flock of the lock file of a segment, -1 if it cannot be opened
+    inline int _cache_shm_lock(const std::string &shm_name) {
+        int fd = shm_open((shm_name + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0) {
+            flock(fd, LOCK_EX);
+        }
+        return fd;
+    }
+
+    inline void _cache_shm_unlock(int lock_fd) {
+        flock(lock_fd, LOCK_UN);
+        close(lock_fd);
+    }
+
+    //  "" if the segment holds the table, "stale" if it holds an older table or
+    //  its filling process died, "incompatible" if it is written by another version
+    inline std::string _cache_shm_check(
+            const _cache_shm_header &h, const std::string &type, u64 type_size, const std::array<u8, 32> &sha256) {
+        if (h.magic != cache_shm_magic or h.version != cache_version
+            or h.type_size != type_size or _cache_string(h.type) != type) {
+            return "incompatible";
+        }
+        if (h.ready.load() != 1 or h.sha256 != sha256) {
+            return "stale";
+        }
+        return "";
+    }
+
+    //  remove the segment only if the name still refers to it, not to a newer one
+    inline void _cache_shm_unlink(const std::string &shm_name, u64 ino) {
+        int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+        if (fd >= 0) {
+            struct stat st{};
+            if (fstat(fd, &st) == 0 and u64(st.st_ino) == ino) {
+                shm_unlink(shm_name.c_str());
+            }
+            close(fd);
+        }
+    }
+
+    //  fd holds the shared flock of this process until the table is released
+    template<typename T>
+    cache_ptr<T> _cache_shm_ptr(const std::string &shm_name, u64 ino, int fd, _cache_shm_header *h, const void *p) {
+        return cache_ptr<T>(reinterpret_cast<const T *>(p), [shm_name, ino, fd, h](const T *q) -> void {
+            munmap(const_cast<T *>(q), _cache_round_up(sizeof(T)));
+            munmap(h, cache_align);
+            int lock_fd = _cache_shm_lock(shm_name);
+            if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+                _cache_shm_unlink(shm_name, ino);
+            }
+            close(fd);
+            if (lock_fd >= 0) {
+                _cache_shm_unlock(lock_fd);
+            }
+        });
+    }
+
+    //  called with the lock file held
+    template<typename T>
+    cache_ptr<T> _cache_shm_create(
+            const std::string &name, const std::string &shm_name, const std::string &path,
+            const cache_section &section) {
+        int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            return nullptr;
+        }
+        flock(fd, LOCK_SH);
+        u64 size = _cache_round_up(sizeof(T));
+        void *hp = MAP_FAILED;
+        void *p = MAP_FAILED;
+        if (ftruncate(fd, off_t(cache_align + size)) == 0) {
+            hp = mmap(nullptr, cache_align, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, off_t(cache_align));
+        }
+        bool ok = hp != MAP_FAILED and p != MAP_FAILED;
+        if (ok) {
+            u64 n_stream = sizeof(T) >= cache_chunk_size or section.codec != cache_codec_none
+                           ? std::max(cache_options.n_stream, u64(1)) : 1;
+            ok = std::get<0>(_cache_read_verify(name, path, section, p, n_stream, false));
+        }
+        if (not ok) {
+            if (hp != MAP_FAILED) {
+                munmap(hp, cache_align);
+            }
+            if (p != MAP_FAILED) {
+                munmap(p, size);
+            }
+            shm_unlink(shm_name.c_str());
+            close(fd);
+            return nullptr;
+        }
+        mprotect(p, size, PROT_READ);
+        _cache_shm_header *h = new(hp) _cache_shm_header{
+                cache_shm_magic, cache_version, {0}, sizeof(T), _cache_string<96>(cache_type_name<T>()), section.sha256
+        };
+        h->ready.store(1);
+        struct stat st{};
+        fstat(fd, &st);
+        std::cout << "cache_data: shm " << name << " created, size=" << sizeof(T) << std::endl;
+        return _cache_shm_ptr<T>(shm_name, u64(st.st_ino), fd, h, p);
+    }
+
+    //  called with the lock file held, a segment which does not hold the table is removed once no process holds it
+    template<typename T>
+    cache_ptr<T> _cache_shm_attach(const std::string &name, const std::string &shm_name, const cache_section &section) {
+        int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        flock(fd, LOCK_SH);
+        u64 size = _cache_round_up(sizeof(T));
+        struct stat st{};
+        fstat(fd, &st);
+        std::string error = "incompatible";
+        void *hp = MAP_FAILED;
+        if (u64(st.st_size) == cache_align + size) {
+            hp = mmap(nullptr, cache_align, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (hp != MAP_FAILED) {
+            _cache_shm_header *h = reinterpret_cast<_cache_shm_header *>(hp);
+            error = _cache_shm_check(*h, cache_type_name<T>(), sizeof(T), section.sha256);
+            if (error.empty()) {
+                void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, off_t(cache_align));
+                if (p != MAP_FAILED) {
+                    std::cout << "cache_data: shm " << name << " attached" << std::endl;
+                    return _cache_shm_ptr<T>(shm_name, u64(st.st_ino), fd, h, p);
+                }
+                error = "cannot map";
+            }
+            munmap(hp, cache_align);
+        }
+        if (error != "cannot map" and flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            std::cout << "cache_data: shm " << name << " " << error << ", remove" << std::endl;
+            _cache_shm_unlink(shm_name, u64(st.st_ino));
+        }
+        close(fd);
+        return nullptr;
+    }
+
+    //  attach to the shared segment of the table, or create it from the cache file,
+    //  a stale or incompatible segment is removed and created again
+    template<typename T>
+    cache_ptr<T> _cache_shm(const std::string &name, const std::string &path, const cache_section &section) {
+        std::string shm_name = cache_shm_name(name);
+        int lock_fd = _cache_shm_lock(shm_name);
+        if (lock_fd < 0) {
+            return nullptr;
+        }
+        cache_ptr<T> p = _cache_shm_attach<T>(name, shm_name, section);
+        if (p == nullptr) {
+            p = _cache_shm_create<T>(name, shm_name, path, section);
+        }
+        _cache_shm_unlock(lock_fd);
+        return p;
+    }
+
+    template<typename T>
+    std::array<u8, 32> _cache_save(const std::string &dir, const std::string &name, const T &data) {
+        std::filesystem::create_directory(dir);
+        std::vector<cache_section> sections{make_cache_section<T>(name, data)};
+        write_cache_file(dir + name, sections, cache_options.n_stream);
+        return sections[0].sha256;
+    }
+
+    //  the table whose init runs in cache_data on this thread, and whether init wrote its file by cache_stream_save
+    struct _cache_computing {
+        std::string name;
+        bool saved;
+    };
+
+    inline thread_local _cache_computing cache_computing{};
+
+    //  the checkpoint an init may have left for the table, removed once the cache file is in place,
+    //  so a build stopped while saving still resumes
+    inline void _cache_remove_checkpoint(const std::string &dir, const std::string &name) {
+        std::error_code ec;
+        std::filesystem::remove(dir + name + ".checkpoint", ec);
+    }
+
+    //  init of a table may write its cache file part by part instead of filling the table,
+    //  so a table larger than memory is never resident, cache_data then maps the file
+    inline bool cache_streamable(const std::string &name) {
+        return cache_computing.name == name and not cache_computing.saved;
+    }
+
+    //  part(q, buf) fills buf with the bytes of part q, the parts are written in order without compression
+    template<typename T>
+    void cache_stream_save(const std::string &name, u64 n_part,
+                           const std::function<void(u64, std::vector<u8> &)> &part) {
+        assert(cache_streamable(name));
+        std::string dir = "cache/";
+        std::filesystem::create_directory(dir);
+        std::string path = dir + name;
+        std::vector<cache_section> sections{cache_section{
+                name, type_desc<T>::name(), sizeof(T), type_desc<T>::shape(), _cache_header_size(1), sizeof(T), {},
+                cache_codec_none, 0, nullptr
+        }};
+        std::string tmp = _cache_tmp_path(path);
+        {
+            std::ofstream f{tmp, std::ios::binary};
+            std::vector<char> header(sections[0].offset, 0);
+            f.write(header.data(), header.size());
+            sha256 hash{};
+            std::vector<u8> buf{};
+            u64 size = 0;
+            for (u64 q = 0; q < n_part; q++) {
+                buf.clear();
+                part(q, buf);
+                hash.update(buf.data(), buf.size());
+                f.write(reinterpret_cast<const char *>(buf.data()), std::streamsize(buf.size()));
+                size += buf.size();
+            }
+            if (size != sizeof(T)) {
+                throw std::runtime_error("cache_stream_save: " + name + " has " + std::to_string(size) + " bytes");
+            }
+            sections[0].sha256 = hash.digest();
+            std::vector<u8> h = _cache_header(sections);
+            f.seekp(0);
+            f.write(reinterpret_cast<const char *>(h.data()), std::streamsize(h.size()));
+            f.close();
+            if (not f) {
+                throw std::runtime_error("cache_stream_save: write " + tmp);
+            }
+        }
+        std::filesystem::rename(tmp, path);
+        cache_computing.saved = true;
+    }
+
+    //  tables with the same content are kept once per process, for example all "*.mul_co" of cube3,
+    //  keyed by type name, size and sha256, the first table of each content owns the entry
+    struct _cache_registry {
+        typedef std::tuple<std::string, u64, std::array<u8, 32>> t_key;
+
+        std::mutex mutex;
+        std::map<t_key, std::tuple<std::string, std::weak_ptr<const void>>> tables;
+
+        //  held while a table is looked up and loaded, so concurrent loads of one content make one copy
+        std::map<t_key, std::mutex> loading;
+
+        //  held by name while a table is found or computed, so solvers built at the same time,
+        //  as the targets of tablegen, compute a table they share once and the others load it
+        std::map<std::string, std::mutex> names;
+
+        //  numa replicas of the tables, with their name and size, alive while a solver uses them
+        std::vector<std::tuple<std::string, std::weak_ptr<const void>, u64>> replicas;
+    };
+
+    inline _cache_registry cache_registry{};
+
+    template<typename T>
+    std::mutex &_cache_loading(const std::array<u8, 32> &sha256) {
+        std::lock_guard<std::mutex> lock(cache_registry.mutex);
+        return cache_registry.loading[{type_desc<T>::name(), sizeof(T), sha256}];
+    }
+
+    inline std::mutex &_cache_name_lock(const std::string &name) {
+        std::lock_guard<std::mutex> lock(cache_registry.mutex);
+        return cache_registry.names[name];
+    }
+
+    template<typename T>
+    cache_ptr<T> _cache_share(const std::string &name, const std::array<u8, 32> &sha256) {
+        std::lock_guard<std::mutex> lock(cache_registry.mutex);
+        auto it = cache_registry.tables.find({type_desc<T>::name(), sizeof(T), sha256});
+        if (it == cache_registry.tables.end()) {
+            return nullptr;
+        }
+        auto[owner, table] = it->second;
+        cache_ptr<T> p = std::static_pointer_cast<const T>(table.lock());
+        if (p != nullptr) {
+            std::cout << "cache_data: share " << name << " with " << owner << std::endl;
+        }
+        return p;
+    }
+
+    template<typename T>
+    void _cache_register(const std::string &name, const std::array<u8, 32> &sha256, const cache_ptr<T> &p) {
+        std::lock_guard<std::mutex> lock(cache_registry.mutex);
+        auto &entry = cache_registry.tables[{type_desc<T>::name(), sizeof(T), sha256}];
+        if (std::get<1>(entry).expired()) {
+            entry = {name, p};
+        }
+    }
+
+    //  tables alive in this process, once per content, with the name of their owner and their size
+    inline std::vector<std::tuple<std::string, std::shared_ptr<const void>, u64>> cache_tables() {
+        std::lock_guard<std::mutex> lock(cache_registry.mutex);
+        std::vector<std::tuple<std::string, std::shared_ptr<const void>, u64>> tables{};
+        for (const auto &[key, entry]: cache_registry.tables) {
+            std::shared_ptr<const void> p = std::get<1>(entry).lock();
+            if (p != nullptr) {
+                tables.emplace_back(std::get<0>(entry), p, std::get<1>(key));
+            }
+        }
+        std::vector<std::tuple<std::string, std::weak_ptr<const void>, u64>> &replicas = cache_registry.replicas;
+        replicas.erase(std::remove_if(replicas.begin(), replicas.end(), [](const auto &r) -> bool {
+            return std::get<1>(r).expired();
+        }), replicas.end());
+        for (const auto &[name, replica, size]: replicas) {
+            std::shared_ptr<const void> p = replica.lock();
+            if (p != nullptr) {
+                tables.emplace_back(name, p, size);
+            }
+        }
+        std::sort(tables.begin(), tables.end());
+        return tables;
+    }
+
+    //  bytes of [p, p + size) in memory, zero where mincore is not available
+    inline u64 cache_resident(const void *p, u64 size) {
+        u64 page_size = u64(sysconf(_SC_PAGESIZE));
+        uintptr_t start = reinterpret_cast<uintptr_t>(p) / page_size * page_size;
+        uintptr_t end = reinterpret_cast<uintptr_t>(p) + size;
+        u64 n_page = (end - start + page_size - 1) / page_size;
+#ifdef __APPLE__
+        std::vector<char> vec(n_page);
+#else
+        std::vector<unsigned char> vec(n_page);
+#endif
+        if (mincore(reinterpret_cast<void *>(start), end - start, vec.data()) != 0) {
+            return 0;
+        }
+        u64 n = 0;
+        for (u64 i = 0; i < n_page; i++) {
+            n += vec[i] & 1;
+        }
+        return std::min(n * page_size, size);
+    }
+
+    inline u64 _read_u64_file(const std::string &path) {
+        std::ifstream f(path);
+        std::string x;
+        if (not (f >> x) or x.empty() or not std::isdigit(static_cast<unsigned char>(x[0]))) {
+            return u64(-1);
+        }
+        return std::stoull(x);
+    }
+
+    //  bytes of memory this process may still take, the smaller of MemAvailable of /proc/meminfo
+    //  and what is left under the memory limit of its cgroup (v2 memory.max, v1 memory.limit_in_bytes),
+    //  with where the number comes from, u64(-1) and "unknown" when neither is readable
+    inline std::tuple<u64, std::string> cache_memory_available() {
+        u64 available = u64(-1);
+        std::string source = "unknown";
+        std::ifstream meminfo("/proc/meminfo");
+        std::string line;
+        while (std::getline(meminfo, line)) {
+            unsigned long kb = 0;
+            if (sscanf(line.c_str(), "MemAvailable: %lu kB", &kb) == 1) {
+                available = u64(kb) << 10;
+                source = "meminfo";
+            }
+        }
+
+        std::vector<std::tuple<std::string, std::string>> limits{};
+        std::ifstream cgroup("/proc/self/cgroup");
+        while (std::getline(cgroup, line)) {
+            u64 i = line.find(":memory:");
+            if (line.rfind("0::", 0) == 0) {
+                std::string dir = "/sys/fs/cgroup" + line.substr(3);
+                limits.emplace_back(dir + "/memory.max", dir + "/memory.current");
+            } else if (i != std::string::npos) {
+                std::string dir = "/sys/fs/cgroup/memory" + line.substr(i + 8);
+                limits.emplace_back(dir + "/memory.limit_in_bytes", dir + "/memory.usage_in_bytes");
+            }
+        }
+        limits.emplace_back("/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory.current");
+        limits.emplace_back("/sys/fs/cgroup/memory/memory.limit_in_bytes",
+                            "/sys/fs/cgroup/memory/memory.usage_in_bytes");
+        for (const auto &[limit_path, usage_path]: limits) {
+            u64 limit = _read_u64_file(limit_path);
+            u64 usage = _read_u64_file(usage_path);
+            if (limit != u64(-1) and usage != u64(-1)) {
+                u64 left = limit > usage ? limit - usage : 0;
+                if (left < available) {
+                    available = left;
+                    source = "cgroup";
+                }
+                break;
+            }
+        }
+        return {available, source};
+    }
+
+    //  fault in every page of the tables alive on n_thread threads, so the first searches do not wait for them,
+    //  with lock the tables are also locked in memory so they are not evicted under memory pressure,
+    //  the resident bytes of each table are printed
+    inline void cache_warmup(u64 n_thread, bool lock) {
+        std::vector<std::tuple<std::string, std::shared_ptr<const void>, u64>> tables = cache_tables();
+        std::vector<std::tuple<const u8 *, u64>> chunks{};
+        for (const auto &[name, p, size]: tables) {
+            for (u64 start = 0; start < size; start += cache_chunk_size) {
+                chunks.emplace_back(reinterpret_cast<const u8 *>(p.get()) + start,
+                                    std::min(cache_chunk_size, size - start));
+            }
+        }
+        u64 page_size = u64(sysconf(_SC_PAGESIZE));
+        std::atomic<u64> next{0};
+        std::atomic<u64> sink{0};
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> future{};
+        for (u64 t = 0; t < std::max(n_thread, u64(1)); t++) {
+            future.push_back(std::async(std::launch::async, [&]() -> void {
+                u64 sum = 0;
+                for (u64 i = next++; i < chunks.size(); i = next++) {
+                    auto[q, size] = chunks[i];
+                    for (u64 j = 0; j < size; j += page_size) {
+                        sum += q[j];
+                    }
+                }
+                sink += sum;
+            }));
+        }
+        for (std::future<void> &f: future) {
+            f.get();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        u64 total_size = 0;
+        u64 total_resident = 0;
+        for (const auto &[name, p, size]: tables) {
+            std::string locked = "no";
+            if (lock) {
+                locked = mlock(p.get(), size) == 0 ? "yes" : std::string("failed, ") + strerror(errno);
+            }
+            u64 resident = cache_resident(p.get(), size);
+            std::cout << "cache_warmup: " << name << ", size=" << size << ", resident=" << resident
+                      << ", mlock=" << locked << std::endl;
+            total_size += size;
+            total_resident += resident;
+        }
+        std::chrono::duration<double> d = t1 - t0;
+        std::cout << "cache_warmup: n_table=" << tables.size() << ", size=" << total_size
+                  << ", resident=" << total_resident << ", n_thread=" << n_thread << ", time=" << d.count() << "s"
+                  << std::endl;
+    }
+
+    inline void _cache_report_huge_page(const std::string &name, const void *p) {
+        if (cache_options.huge_page == "none" or cache_options.mmap or cache_options.shm) {
+            return;
+        }
+        auto[page_size, huge] = cache_huge_page_usage(p);
+        std::cout << "cache_data: huge_page " << name << ", page_size=" << page_size
+                  << ", huge=" << huge << std::endl;
+    }
+
+    struct _cache_event {
+        std::string name;
+        std::string action;
+        std::string verify;
+        u64 size;
+        std::array<u8, 32> sha256;
+        double start;
+        double end;
+    };
+
+    //  when each table was shared, mapped, loaded or computed, relative to the start of the program
+    struct _cache_timeline {
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        std::vector<_cache_event> events;
+    };
+
+    inline _cache_timeline cache_timeline{};
+
+    inline std::vector<_cache_event> cache_events() {
+        std::lock_guard<std::mutex> lock(cache_timeline.mutex);
+        return cache_timeline.events;
+    }
+
+    //  print the tables loaded since the last call, ordered by start time
+    inline void print_cache_timeline() {
+        std::lock_guard<std::mutex> lock(cache_timeline.mutex);
+        std::vector<_cache_event> &events = cache_timeline.events;
+        if (events.empty()) {
+            return;
+        }
+        std::stable_sort(events.begin(), events.end(), [](const _cache_event &a, const _cache_event &b) -> bool {
+            return a.start < b.start;
+        });
+        double start = events[0].start;
+        double end = 0.0;
+        double sum = 0.0;
+        for (const _cache_event &e: events) {
+            std::cout << "cache_timeline: " << e.name << ", action=" << e.action
+                      << ", start=" << e.start << "s, end=" << e.end << "s, time=" << e.end - e.start << "s";
+            if (not e.verify.empty()) {
+                std::cout << ", verify=" << e.verify;
+            }
+            std::cout << std::endl;
+            end = std::max(end, e.end);
+            sum += e.end - e.start;
+        }
+        std::cout << "cache_timeline: n_table=" << events.size() << ", time=" << end - start
+                  << "s, sum_time=" << sum << "s" << std::endl;
+        events.clear();
+    }
+
+    //  types of the tables cache_data skips on this thread and on the threads of cache_data_async started from it,
+    //  for a solver whose table of a type is not needed by the solver built from it
+    inline thread_local std::set<std::string> cache_skipped{};
+
+    template<typename T>
+    std::string _cache_type_key() {
+        return cache_type_name<T>() + "/" + std::to_string(sizeof(T));
+    }
+
+    //  cache_data returns nullptr for the tables of type T while it lives
+    template<typename T>
+    struct cache_skip {
+        cache_skip() {
+            cache_skipped.insert(_cache_type_key<T>());
+        }
+
+        cache_skip(const cache_skip &) = delete;
+
+        ~cache_skip() {
+            cache_skipped.erase(_cache_type_key<T>());
+        }
+    };
+
+    template<typename T>
+    std::tuple<cache_ptr<T>, std::string, std::string, std::array<u8, 32>> _cache_data(
+            const std::string &name, const std::function<void(T &)> &init) {
+        std::string dir = "cache/";
+        std::lock_guard<std::mutex> by_name(_cache_name_lock(name));
+        auto[found, error, path, section] = _cache_find<T>(dir, name);
+        std::unique_lock<std::mutex> loading{};
+        if (found and error.empty()) {
+            loading = std::unique_lock<std::mutex>(_cache_loading<T>(section.sha256));
+            cache_ptr<T> p = _cache_share<T>(name, section.sha256);
+            if (p != nullptr) {
+                return {p, "share", "", section.sha256};
+            }
+        }
+        std::string verify = "";
+        if (found) {
+            cache_ptr<T> p = nullptr;
+            std::string action = "load";
+            if (cache_options.shm and error.empty()) {
+                p = _cache_shm<T>(name, path, section);
+                action = "shm";
+            }
+            if (p == nullptr and cache_options.mmap and section.codec == cache_codec_none) {
+                std::cout << "cache_data: map " << name << " ..." << std::endl;
+                p = _cache_map<T>(path, section.offset);
+                std::cout << "cache_data: map " << name << (p ? " ok" : " failed") << std::endl;
+                action = "map";
+                if (p != nullptr and cache_options.verify != "none") {
+                    //  reads the whole mapping, the start up time of mmap is lost
+                    sha256 hash{};
+                    hash.update(p.get(), sizeof(T));
+                    verify = _cache_check(name, _cache_expected(name, section.sha256), hash.digest());
+                    if (verify == "failed") {
+                        p = nullptr;
+                    }
+                }
+            }
+            if (p == nullptr and verify != "failed") {
+                std::cout << "cache_data: load " << name << " ..." << std::endl;
+                std::tie(p, verify) = _cache_read<T>(name, path, section);
+                action = "load";
+            }
+            if (verify == "failed") {
+                if (cache_options.verify == "refuse") {
+                    throw std::runtime_error("verify " + name + " failed, refuse " + path);
+                }
+                std::cout << "cache_data: verify " << name << " failed, rebuild" << std::endl;
+            }
+            if (p != nullptr and error == "legacy") {
+                std::cout << "cache_data: upgrade " << name << " ..." << std::endl;
+                section.sha256 = _cache_save<T>(dir, name, *p);
+                std::cout << "cache_data: upgrade " << name << " ok" << std::endl;
+            }
+            if (p != nullptr) {
+                _cache_report_huge_page(name, p.get());
+                _cache_register<T>(name, section.sha256, p);
+                return {p, action, verify, section.sha256};
+            }
+        } else if (not path.empty()) {
+            std::cout << "cache_data: reject " << path << ", " << error << std::endl;
+        }
+        if (loading.owns_lock()) {
+            loading.unlock();
+        }
+        //  the pages of the table are not touched until init writes them
+        std::shared_ptr<T> p = cache_alloc<T>();
+        std::cout << "cache_data: compute " << name << " ..." << std::endl;
+        auto t0 = std::chrono::steady_clock::now();
+        cache_computing = _cache_computing{name, false};
+        try {
+            init(*p);
+        } catch (...) {
+            cache_computing = _cache_computing{};
+            throw;
+        }
+        bool streamed = cache_computing.saved;
+        cache_computing = _cache_computing{};
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t1 - t0;
+        std::cout << "cache_data: compute " << name << " ok, time=" << d.count() << "s" << std::endl;
+        if (streamed) {
+            p = nullptr;
+            auto[found_s, error_s, path_s, section_s] = _cache_find<T>(dir, name);
+            cache_ptr<T> q = found_s and error_s.empty() ? _cache_map<T>(path_s, section_s.offset) : nullptr;
+            if (found_s and error_s.empty() and q == nullptr) {
+                std::tie(q, verify) = _cache_read<T>(name, path_s, section_s);
+            }
+            if (q == nullptr) {
+                throw std::runtime_error("cannot open " + dir + name + " written by its init");
+            }
+            std::cout << "cache_data: map " << name << " ok" << std::endl;
+            _cache_remove_checkpoint(dir, name);
+            if (cache_options.verify != "none") {
+                verify = _cache_check(name, _cache_expected(name, {}), section_s.sha256);
+                if (verify == "failed" and cache_options.verify == "refuse") {
+                    throw std::runtime_error("verify " + name + " failed, refuse computed table");
+                }
+            }
+            _cache_register<T>(name, section_s.sha256, q);
+            return {q, "compute", verify, section_s.sha256};
+        }
+        _cache_report_huge_page(name, p.get());
+        std::cout << "cache_data: save " << name << " ..." << std::endl;
+        std::array<u8, 32> digest = _cache_save<T>(dir, name, *p);
+        std::cout << "cache_data: save " << name << " ok" << std::endl;
+        _cache_remove_checkpoint(dir, name);
+        if (cache_options.verify != "none") {
+            //  a computed table which differs from the manifest points to a bug, not to a bad file
+            verify = _cache_check(name, _cache_expected(name, {}), digest);
+            if (verify == "failed" and cache_options.verify == "refuse") {
+                throw std::runtime_error("verify " + name + " failed, refuse computed table");
+            }
+        }
+        _cache_register<T>(name, digest, p);
+        return {p, "compute", verify, digest};
+    }
+
+    template<typename T>
+    cache_ptr<T> cache_data(const std::string &name, const std::function<void(T &)> &init) {
+        if (cache_skipped.count(_cache_type_key<T>()) > 0) {
+            std::cout << "cache_data: skip " << name << std::endl;
+            return nullptr;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        auto[p, action, verify, digest] = _cache_data<T>(name, init);
+        auto t1 = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(cache_timeline.mutex);
+        std::chrono::duration<double> start = t0 - cache_timeline.epoch;
+        std::chrono::duration<double> end = t1 - cache_timeline.epoch;
+        cache_timeline.events.push_back(
+                _cache_event{name, action, verify, sizeof(T), digest, start.count(), end.count()});
+        return p;
+    }
+
+    //  a copy of a table in the memory of a numa node, copied by cache_options.n_stream threads,
+    //  the table itself when there is only one node, the copy is registered as "<name>.node<id>"
+    //  so cache_warmup and print_cache_timeline see it
+    template<typename T>
+    cache_ptr<T> cache_replicate(const std::string &name, const cache_ptr<T> &p, u64 node) {
+        if (numa_nodes().size() <= 1) {
+            return p;
+        }
+        std::string replica_name = name + ".node" + std::to_string(numa_nodes()[node].id);
+        auto t0 = std::chrono::steady_clock::now();
+        std::shared_ptr<T> q = cache_alloc<T>(node);
+        const u8 *src = reinterpret_cast<const u8 *>(p.get());
+        u8 *dst = reinterpret_cast<u8 *>(q.get());
+        u64 n_page = (sizeof(T) + cache_align - 1) / cache_align;
+        parallel_for(n_page, std::max(cache_options.n_stream, u64(1)), [&](u64 start, u64 end) -> void {
+            u64 s = std::min(start * cache_align, u64(sizeof(T)));
+            u64 e = std::min(end * cache_align, u64(sizeof(T)));
+            memcpy(dst + s, src + s, e - s);
+        });
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t1 - t0;
+        std::cout << "cache_replicate: " << name << ", node=" << numa_nodes()[node].id << ", size=" << sizeof(T)
+                  << ", time=" << d.count() << "s" << std::endl;
+        std::array<u8, 32> digest{};
+        {
+            std::lock_guard<std::mutex> lock(cache_registry.mutex);
+            for (const auto &[key, entry]: cache_registry.tables) {
+                if (std::get<1>(entry).lock() == p) {
+                    digest = std::get<2>(key);
+                }
+            }
+            cache_registry.replicas.emplace_back(replica_name, q, sizeof(T));
+        }
+        std::lock_guard<std::mutex> lock(cache_timeline.mutex);
+        std::chrono::duration<double> start = t0 - cache_timeline.epoch;
+        std::chrono::duration<double> end = t1 - cache_timeline.epoch;
+        cache_timeline.events.push_back(
+                _cache_event{replica_name, "replicate", "", sizeof(T), digest, start.count(), end.count()});
+        return q;
+    }
+
+    template<typename T>
+    using cache_future = std::shared_future<cache_ptr<T>>;
+
+    //  cache_data on a thread of its own, init waits for the futures of the tables it is built from,
+    //  so a table found in the cache never waits for its inputs
+    template<typename T>
+    cache_future<T> cache_data_async(const std::string &name, const std::function<void(T &)> &init) {
+        return std::async(std::launch::async, [name, init, skipped = cache_skipped]() -> cache_ptr<T> {
+            cache_skipped = skipped;
+            return cache_data<T>(name, init);
+        }).share();
+    }
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "cxxopts.hpp"
+
+#include "base.h"
+#include "cache.h"
+
+using namespace cube;
+
+void parse_arg(
+        int argc, char **argv,
+        std::string &codec, u64 &n_thread, std::string &input, std::string &output) {
+    std::set<std::string> codec_set = {"none", "huffman"};
+    std::tuple<u64, u64> n_thread_t = {1, 256};
+
+    cxxopts::Options option(argv[0], "Convert cache files between raw and compressed tables");
+    option.add_options()
+            ("codec", "(none | huffman)", cxxopts::value<std::string>(codec)->default_value("huffman"))
+            ("n_thread", "1~256", cxxopts::value<u64>(n_thread)->default_value("4"))
+            ("input", "input cache file", cxxopts::value<std::string>(input))
+            ("output", "output cache file, the input file by default", cxxopts::value<std::string>(output))
+            ("help", "show help");
+
+    try {
+        cxxopts::ParseResult result = option.parse(argc, argv);
+        if (result.count("help") > 0 or result.count("input") == 0) {
+            std::cout << option.help() << std::endl;
+            exit(0);
+        }
+        if (result.count("output") == 0) {
+            output = input;
+        }
+    } catch (const cxxopts::OptionException &e) {
+        std::cout << "error option: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    if (codec_set.find(codec) == codec_set.end()) {
+        std::cout << "error codec: " << codec << std::endl;
+        exit(1);
+    }
+
+    if (n_thread < std::get<0>(n_thread_t) or n_thread > std::get<1>(n_thread_t)) {
+        std::cout << "error n_thread: " << n_thread << std::endl;
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string codec;
+    u64 n_thread;
+    std::string input;
+    std::string output;
+
+    parse_arg(argc, argv, codec, n_thread, input, output);
+
+    auto[ok, error, sections] = read_cache_header(input);
+    if (not ok) {
+        std::cout << "cache_tool: reject " << input << ", " << error << std::endl;
+        if (error == "bad magic") {
+            //  a raw dump carries no name or type, only the solver knows which table it is
+            std::cout << "cache_tool: a raw cache file is upgraded by loading it once with solver or tablegen"
+                      << std::endl;
+        }
+        return 1;
+    }
+
+    std::vector<std::vector<u8>> tables(sections.size());
+    for (u64 i = 0; i < sections.size(); i++) {
+        cache_section &s = sections[i];
+        tables[i].resize(s.type_size);
+        auto t0 = std::chrono::steady_clock::now();
+        if (not std::get<0>(read_section(input, s, tables[i].data(), n_thread, false))) {
+            std::cout << "cache_tool: read " << s.name << " failed" << std::endl;
+            return 1;
+        }
+        sha256 hash{};
+        hash.update(tables[i].data(), s.type_size);
+        if (hash.digest() != s.sha256) {
+            std::cout << "cache_tool: read " << s.name << " failed, bad sha256" << std::endl;
+            return 1;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t1 - t0;
+        std::cout << "cache_tool: read " << s.name << " ok, size=" << s.type_size
+                  << ", stored_size=" << s.size << ", time=" << d.count() << "s" << std::endl;
+        s.codec = codec == "huffman" ? cache_codec_huffman : cache_codec_none;
+        s.chunk_size = cache_codec_chunk_size;
+        s.data = tables[i].data();
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    write_cache_file(output, sections, n_thread);
+    auto t1 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d = t1 - t0;
+    for (const cache_section &s: sections) {
+        std::cout << "cache_tool: write " << s.name << " ok, codec=" << codec << ", size=" << s.type_size
+                  << ", stored_size=" << s.size << std::endl;
+    }
+    std::cout << "cache_tool: write " << output << " ok, time=" << d.count() << "s" << std::endl;
+    return 0;
+}
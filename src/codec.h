@@ -0,0 +1,204 @@
+#ifndef _CODEC_H
+#define _CODEC_H
+
+#include <cstring>
+
+#include "base.h"
+
+//  byte oriented canonical huffman codec for cache tables
+//
+//  a block is compressed on its own, so blocks of a table can be decoded in parallel
+//
+//  block      mode (1 byte), 0 for stored bytes, 1 for huffman codes
+//  stored     the bytes
+//  huffman    code length of each byte value, 4 bits each, 128 bytes
+//             codes, least significant bit first, padded with 8 zero bytes
+
+namespace cube {
+    struct huffman_codec {
+        static constexpr u64 max_len = 12;
+        static constexpr u64 n_symbol = 256;
+        static constexpr u64 n_table = u64(1) << max_len;
+        static constexpr u64 n_pad = 8;
+
+        static std::array<u8, n_symbol> code_len(const std::array<u64, n_symbol> &count) {
+            std::array<u8, n_symbol> len{};
+            std::array<u64, n_symbol> c = count;
+            while (true) {
+                //  huffman tree over the symbols present, merging the two lightest nodes
+                std::vector<std::tuple<u64, u64>> heap{};
+                std::vector<u64> parent{};
+                for (u64 s = 0; s < n_symbol; s++) {
+                    if (c[s] > 0) {
+                        heap.emplace_back(c[s], parent.size());
+                        parent.push_back(u64(-1));
+                    }
+                }
+                u64 n_leaf = parent.size();
+                if (n_leaf == 0) {
+                    return len;
+                }
+                auto greater = std::greater<std::tuple<u64, u64>>();
+                std::make_heap(heap.begin(), heap.end(), greater);
+                while (heap.size() > 1) {
+                    std::pop_heap(heap.begin(), heap.end(), greater);
+                    auto[w0, i0] = heap.back();
+                    heap.pop_back();
+                    std::pop_heap(heap.begin(), heap.end(), greater);
+                    auto[w1, i1] = heap.back();
+                    heap.pop_back();
+                    parent[i0] = parent.size();
+                    parent[i1] = parent.size();
+                    heap.emplace_back(w0 + w1, parent.size());
+                    std::push_heap(heap.begin(), heap.end(), greater);
+                    parent.push_back(u64(-1));
+                }
+                std::vector<u64> depth(parent.size(), 0);
+                for (u64 i = parent.size() - 1; i-- > 0;) {
+                    depth[i] = depth[parent[i]] + 1;
+                }
+                u64 max_depth = 0;
+                for (u64 s = 0, i = 0; s < n_symbol; s++) {
+                    if (c[s] > 0) {
+                        len[s] = u8(std::max(depth[i], u64(1)));
+                        max_depth = std::max(max_depth, u64(len[s]));
+                        i++;
+                    }
+                }
+                if (max_depth <= max_len) {
+                    return len;
+                }
+                //  flatten the counts until the longest code fits
+                for (u64 s = 0; s < n_symbol; s++) {
+                    if (c[s] > 0) {
+                        c[s] = (c[s] + 1) / 2;
+                    }
+                }
+            }
+        }
+
+        //  canonical codes, bit reversed for the least significant bit first stream
+        static std::array<u16, n_symbol> code(const std::array<u8, n_symbol> &len) {
+            std::array<u16, n_symbol> codes{};
+            u64 next = 0;
+            for (u64 l = 1; l <= max_len; l++) {
+                for (u64 s = 0; s < n_symbol; s++) {
+                    if (len[s] == l) {
+                        u64 r = 0;
+                        for (u64 b = 0; b < l; b++) {
+                            r |= ((next >> b) & 1) << (l - 1 - b);
+                        }
+                        codes[s] = u16(r);
+                        next++;
+                    }
+                }
+                next <<= 1;
+            }
+            return codes;
+        }
+
+        static std::vector<u8> compress(const u8 *src, u64 n) {
+            std::array<u64, n_symbol> count{};
+            for (u64 i = 0; i < n; i++) {
+                count[src[i]]++;
+            }
+            std::array<u8, n_symbol> len = code_len(count);
+            std::array<u16, n_symbol> codes = code(len);
+            u64 n_bit = 0;
+            for (u64 s = 0; s < n_symbol; s++) {
+                n_bit += count[s] * len[s];
+            }
+            u64 size = 1 + n_symbol / 2 + (n_bit + 7) / 8 + n_pad;
+            if (size >= 1 + n) {
+                std::vector<u8> dst(1 + n);
+                dst[0] = 0;
+                std::memcpy(&dst[1], src, n);
+                return dst;
+            }
+            std::vector<u8> dst(size, 0);
+            dst[0] = 1;
+            for (u64 s = 0; s < n_symbol; s += 2) {
+                dst[1 + s / 2] = u8(len[s] | (len[s + 1] << 4));
+            }
+            u8 *out = &dst[1 + n_symbol / 2];
+            u64 buf = 0;
+            u64 n_buf = 0;
+            for (u64 i = 0; i < n; i++) {
+                buf |= u64(codes[src[i]]) << n_buf;
+                n_buf += len[src[i]];
+                while (n_buf >= 8) {
+                    *out++ = u8(buf);
+                    buf >>= 8;
+                    n_buf -= 8;
+                }
+            }
+            if (n_buf > 0) {
+                *out = u8(buf);
+            }
+            return dst;
+        }
+
+        static bool decompress(const u8 *src, u64 n, u8 *dst, u64 dst_n) {
+            if (n == 0) {
+                return false;
+            }
+            if (src[0] == 0) {
+                if (n != 1 + dst_n) {
+                    return false;
+                }
+                std::memcpy(dst, src + 1, dst_n);
+                return true;
+            }
+            if (src[0] != 1 or n < 1 + n_symbol / 2 + n_pad) {
+                return false;
+            }
+            std::array<u8, n_symbol> len{};
+            for (u64 s = 0; s < n_symbol; s += 2) {
+                len[s] = src[1 + s / 2] & 15;
+                len[s + 1] = src[1 + s / 2] >> 4;
+            }
+            for (u64 s = 0; s < n_symbol; s++) {
+                if (len[s] > max_len) {
+                    return false;
+                }
+            }
+            std::array<u16, n_symbol> codes = code(len);
+
+            //  entry is symbol << 4 | code length, a zero length marks an invalid code
+            std::vector<u16> table(n_table, 0);
+            for (u64 s = 0; s < n_symbol; s++) {
+                if (len[s] > 0) {
+                    for (u64 r = codes[s]; r < n_table; r += u64(1) << len[s]) {
+                        table[r] = u16(s << 4 | len[s]);
+                    }
+                }
+            }
+
+            const u8 *in = src + 1 + n_symbol / 2;
+            u64 n_in = n - 1 - n_symbol / 2 - n_pad;
+            u64 pos = 0;
+            u64 i = 0;
+            //  one 8 byte load gives at least 56 bits, enough for 4 codes
+            while (i < dst_n) {
+                if ((pos >> 3) > n_in) {
+                    return false;
+                }
+                u64 buf;
+                std::memcpy(&buf, in + (pos >> 3), 8);
+                buf >>= pos & 7;
+                for (u64 k = 0; k < 4 and i < dst_n; k++) {
+                    u16 e = table[buf & (n_table - 1)];
+                    if ((e & 15) == 0) {
+                        return false;
+                    }
+                    dst[i++] = u8(e >> 4);
+                    buf >>= e & 15;
+                    pos += e & 15;
+                }
+            }
+            return (pos + 7) >> 3 <= n_in;
+        }
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define _CUBE2_H
 
 #include "base.h"
+#include "cache.h"
 #include "group.h"
 #include "search.h"
 
@@ -113,9 +114,14 @@ namespace cube::_2 {
         }
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
-        std::unique_ptr<array_2d < u16, n_co, n_base>> mul_co;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
+        cache_ptr<array_2d < u16, n_co, n_base>> mul_co;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
+
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(mul_cp), decltype(mul_co), decltype(distance_m3)>();
+        }
 
         explicit cube2_solver(u64 _n_thread) : n_thread(_n_thread) {
             mul_cp = cache_data<array_2d<u16, n_cp, n_base>>(
@@ -141,12 +147,12 @@ namespace cube::_2 {
                         }
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            distance_m3 = freeze(cache_data<array_u2<n_state>>(
                     "cube2.distance_m3",
                     [this](array_u2<n_state> &t) -> void {
-                        bfs<cube2_solver>(*this, t, n_thread);
+                        bfs<cube2_solver>(*this, t, n_thread, "cube2.distance_m3");
                     }
-            );
+            ));
         }
 
         std::array<t_state, n_base> adj(const t_state &a) const {
@@ -164,6 +170,9 @@ namespace cube::_2 {
             return ida_star<cube2_solver, capacity>(*this, a, max_n_moves);
         }
     };
+
+    constexpr char _cube2_exact[] = "cube2.distance_u4";
+    typedef exact_solver<cube2_solver, _cube2_exact> cube2_exact_solver;
 }
 
 #endif
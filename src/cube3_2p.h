@@ -2,6 +2,7 @@
 #define _CUBE3_2P_H
 
 #include "base.h"
+#include "cache.h"
 #include "group.h"
 #include "search.h"
 #include "cube3.h"
@@ -66,12 +67,17 @@ namespace cube::_3::_2p {
         }
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_co, n_base>> mul_co;
-        std::unique_ptr<array_2d < u32, n_egp * n_eo, n_base>> mul_egp_eo;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_co, n_base>> mul_co;
+        cache_ptr<array_2d < u32, n_egp * n_eo, n_base>> mul_egp_eo;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
+
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(mul_co), decltype(mul_egp_eo), decltype(distance_m3)>();
+        }
 
         explicit p0_solver(u64 _n_thread) : n_thread(_n_thread) {
-            mul_co = cache_data<array_2d<u16, n_co, n_base>>(
+            auto f_mul_co = cache_data_async<array_2d<u16, n_co, n_base>>(
                     "cube3.p0.mul_co",
                     [](array_2d<u16, n_co, n_base> &t) -> void {
                         for (u64 i = 0; i < n_co; i++) {
@@ -82,28 +88,39 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            mul_egp_eo = cache_data<array_2d<u32, n_egp * n_eo, n_base>>(
+            auto f_mul_egp_eo = cache_data_async<array_2d<u32, n_egp * n_eo, n_base>>(
                     "cube3.p0.mul_egp_eo",
-                    [](array_2d<u32, n_egp * n_eo, n_base> &t) -> void {
-                        for (u64 i = 0; i < n_egp; i++) {
-                            array_u8<12> egp = int_to_gp<os_4_8>(i);
-                            for (u64 j = 0; j < n_eo; j++) {
-                                array_u8<12> eo = int_to_o<12, 2>(j);
-                                for (u64 k = 0; k < n_base; k++) {
-                                    t[i * n_eo + j][k] =
-                                            u32(gp_to_int<os_4_8>(egp * base[k].ep) * n_eo
-                                                + o_to_int<12, 2>(mul_o<12, 2>(eo * base[k].ep, base[k].eo)));
+                    [this](array_2d<u32, n_egp * n_eo, n_base> &t) -> void {
+                        parallel_for(n_egp, n_thread, [&t](u64 start, u64 end) -> void {
+                            for (u64 i = start; i < end; i++) {
+                                array_u8<12> egp = int_to_gp<os_4_8>(i);
+                                for (u64 j = 0; j < n_eo; j++) {
+                                    array_u8<12> eo = int_to_o<12, 2>(j);
+                                    for (u64 k = 0; k < n_base; k++) {
+                                        t[i * n_eo + j][k] =
+                                                u32(gp_to_int<os_4_8>(egp * base[k].ep) * n_eo
+                                                    + o_to_int<12, 2>(mul_o<12, 2>(eo * base[k].ep, base[k].eo)));
+                                    }
                                 }
                             }
-                        }
+                        });
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            auto f_distance_m3 = cache_data_async<array_u2<n_state>>(
                     "cube3.p0.distance_m3",
-                    [this](array_u2<n_state> &t) -> void {
-                        bfs<p0_solver>(*this, t, n_thread);
+                    [_n_thread, f_mul_co, f_mul_egp_eo](array_u2<n_state> &t) -> void {
+                        p0_solver s(_n_thread, f_mul_co.get(), f_mul_egp_eo.get());
+                        bfs<p0_solver>(s, t, _n_thread, "cube3.p0.distance_m3");
                     }
             );
+            mul_co = f_mul_co.get();
+            mul_egp_eo = f_mul_egp_eo.get();
+            distance_m3 = freeze(f_distance_m3.get());
+        }
+
+        //  a solver of the tables given and no distance table, for the bfs which builds it
+        p0_solver(u64 _n_thread, decltype(mul_co) _mul_co, decltype(mul_egp_eo) _mul_egp_eo) :
+                n_thread(_n_thread), mul_co(std::move(_mul_co)), mul_egp_eo(std::move(_mul_egp_eo)) {
         }
 
         std::array<t_state, n_base> adj(const t_state &a) const {
@@ -159,14 +176,19 @@ namespace cube::_3::_2p {
                 generate_table_conj_base<cube3, n_base, n_s16>(base, elements_s16);
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_co, n_s16>> conj_co;
-        std::unique_ptr<array_2d < u16, n_co, n_base>> mul_co;
-        std::unique_ptr<table_conj_mul < u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base>> conj_mul_egp_eo;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_co, n_s16>> conj_co;
+        cache_ptr<array_2d < u16, n_co, n_base>> mul_co;
+        cache_ptr<table_conj_mul < u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base>> conj_mul_egp_eo;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
         t_state _start;
 
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(conj_co), decltype(mul_co), decltype(conj_mul_egp_eo), decltype(distance_m3)>();
+        }
+
         explicit g_p0s_solver(u64 _n_thread) : n_thread(_n_thread) {
-            conj_co = cache_data<array_2d<u16, n_co, n_s16>>(
+            auto f_conj_co = cache_data_async<array_2d<u16, n_co, n_s16>>(
                     std::string("cube3.") + name + ".conj_co",
                     [](array_2d<u16, n_co, n_s16> &t) -> void {
                         cube3 a = cube3::i();
@@ -179,7 +201,7 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            mul_co = cache_data<array_2d<u16, n_co, n_base>>(
+            auto f_mul_co = cache_data_async<array_2d<u16, n_co, n_base>>(
                     std::string("cube3.") + name + ".mul_co",
                     [](array_2d<u16, n_co, n_base> &t) -> void {
                         for (u64 i = 0; i < n_co; i++) {
@@ -190,9 +212,9 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            conj_mul_egp_eo = cache_data<table_conj_mul<u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base>>(
+            auto f_conj_mul_egp_eo = cache_data_async<table_conj_mul<u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base>>(
                     std::string("cube3.") + name + ".conj_mul_egp_eo",
-                    [](table_conj_mul<u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base> &cm) -> void {
+                    [this](table_conj_mul<u32, U_SC, u16, n_egp * n_eo, n_sc_egp_eo, n_s16, n_base> &cm) -> void {
                         cm.init(
                                 [](u32 i) -> std::array<u32, n_s16> {
                                     cube3 a = cube3::i();
@@ -215,16 +237,32 @@ namespace cube::_3::_2p {
                                                        + o_to_int<12, 2>(mul_o<12, 2>(eo * base[j].ep, base[j].eo)));
                                     }
                                     return mul_i;
-                                }
+                                },
+                                n_thread
                         );
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            auto f_distance_m3 = cache_data_async<array_u2<n_state>>(
                     std::string("cube3.") + name + ".distance_m3",
-                    [this](array_u2<n_state> &t) -> void {
-                        bfs<g_p0s_solver<_os_e, U_SC, _n_sc_egp_eo, name>>(*this, t, n_thread);
+                    [_n_thread, f_conj_co, f_mul_co, f_conj_mul_egp_eo](array_u2<n_state> &t) -> void {
+                        g_p0s_solver<_os_e, U_SC, _n_sc_egp_eo, name> s(
+                                _n_thread, f_conj_co.get(), f_mul_co.get(), f_conj_mul_egp_eo.get());
+                        bfs<g_p0s_solver<_os_e, U_SC, _n_sc_egp_eo, name>>(
+                                s, t, _n_thread, std::string("cube3.") + name + ".distance_m3");
                     }
             );
+            conj_co = f_conj_co.get();
+            mul_co = f_mul_co.get();
+            conj_mul_egp_eo = f_conj_mul_egp_eo.get();
+            distance_m3 = freeze(f_distance_m3.get());
+            _start = cube_to_state(t_cube::i());
+        }
+
+        //  a solver of the tables given and no distance table, for the bfs which builds it
+        g_p0s_solver(u64 _n_thread, decltype(conj_co) _conj_co, decltype(mul_co) _mul_co,
+                     decltype(conj_mul_egp_eo) _conj_mul_egp_eo) :
+                n_thread(_n_thread), conj_co(std::move(_conj_co)), mul_co(std::move(_mul_co)),
+                conj_mul_egp_eo(std::move(_conj_mul_egp_eo)) {
             _start = cube_to_state(t_cube::i());
         }
 
@@ -271,12 +309,12 @@ namespace cube::_3::_2p {
             return a_s;
         }
 
-        std::set<u64> alt(const t_state &a, u64 i) const {
+        alt_list alt(const t_state &a, u64 i) const {
             u64 ss = conj_mul_egp_eo->sc_to_ss[a.sc_egp_eo];
+            alt_list a_i(i);
             if (ss == 1) {
-                return std::set<u64>{i};
+                return a_i;
             }
-            std::set<u64> a_i{};
             for (u64 s = 0; s < n_s16; s++) {
                 if ((ss >> s) & u64(1)) {
                     a_i.insert(state_to_int(t_state{
@@ -299,6 +337,9 @@ namespace cube::_3::_2p {
     constexpr char _p0s[] = "p0s";
     typedef g_p0s_solver<os_4_8, u16, 64430, _p0s> p0s_solver;
 
+    constexpr char _p0s_exact[] = "cube3.p0s.distance_u4";
+    typedef exact_solver<p0s_solver, _p0s_exact> p0s_exact_solver;
+
     // phase 1
     struct p1_solver {
         typedef cube3 t_cube;
@@ -350,12 +391,17 @@ namespace cube::_3::_2p {
         }
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_cgp, n_base>> mul_cgp;
-        std::unique_ptr<array_2d < u32, n_ep4 * n_ep8, n_base>> mul_ep4_ep8;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_cgp, n_base>> mul_cgp;
+        cache_ptr<array_2d < u32, n_ep4 * n_ep8, n_base>> mul_ep4_ep8;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
+
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(mul_cgp), decltype(mul_ep4_ep8), decltype(distance_m3)>();
+        }
 
         explicit p1_solver(u64 _n_thread) : n_thread(_n_thread) {
-            mul_cgp = cache_data<array_2d<u16, n_cgp, n_base>>(
+            auto f_mul_cgp = cache_data_async<array_2d<u16, n_cgp, n_base>>(
                     "cube3.p1.mul_cgp",
                     [](array_2d<u16, n_cgp, n_base> &t) -> void {
                         for (u64 i = 0; i < n_cgp; i++) {
@@ -366,7 +412,7 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            mul_ep4_ep8 = cache_data<array_2d<u32, n_ep4 * n_ep8, n_base>>(
+            auto f_mul_ep4_ep8 = cache_data_async<array_2d<u32, n_ep4 * n_ep8, n_base>>(
                     "cube3.p1.mul_ep4_ep8",
                     [](array_2d<u32, n_ep4 * n_ep8, n_base> &t) -> void {
                         for (u64 i = 0; i < n_ep4; i++) {
@@ -382,12 +428,21 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            auto f_distance_m3 = cache_data_async<array_u2<n_state>>(
                     "cube3.p1.distance_m3",
-                    [this](array_u2<n_state> &t) -> void {
-                        bfs<p1_solver>(*this, t, n_thread);
+                    [_n_thread, f_mul_cgp, f_mul_ep4_ep8](array_u2<n_state> &t) -> void {
+                        p1_solver s(_n_thread, f_mul_cgp.get(), f_mul_ep4_ep8.get());
+                        bfs<p1_solver>(s, t, _n_thread, "cube3.p1.distance_m3");
                     }
             );
+            mul_cgp = f_mul_cgp.get();
+            mul_ep4_ep8 = f_mul_ep4_ep8.get();
+            distance_m3 = freeze(f_distance_m3.get());
+        }
+
+        //  a solver of the tables given and no distance table, for the bfs which builds it
+        p1_solver(u64 _n_thread, decltype(mul_cgp) _mul_cgp, decltype(mul_ep4_ep8) _mul_ep4_ep8) :
+                n_thread(_n_thread), mul_cgp(std::move(_mul_cgp)), mul_ep4_ep8(std::move(_mul_ep4_ep8)) {
         }
 
         std::array<t_state, n_base> adj(const t_state &a) const {
@@ -442,29 +497,37 @@ namespace cube::_3::_2p {
                 generate_table_conj_base<cube3, n_base, n_s16>(base, elements_s16);
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_cp, n_s16>> conj_cp;
-        std::unique_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
-        std::unique_ptr<table_conj_mul < u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base>> conj_mul_ep4_ep8;
-        std::unique_ptr<std::array<u8, n_cp>> parity_p8;
-        std::unique_ptr<std::array<u8, n_sc_ep4_ep8>> parity_sc_ep4_ep8;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_cp, n_s16>> conj_cp;
+        cache_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
+        cache_ptr<table_conj_mul < u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base>> conj_mul_ep4_ep8;
+        cache_ptr<std::array<u8, n_cp>> parity_p8;
+        cache_ptr<std::array<u8, n_sc_ep4_ep8>> parity_sc_ep4_ep8;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
         t_state _start;
 
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(conj_cp), decltype(mul_cp), decltype(conj_mul_ep4_ep8), decltype(parity_p8),
+                    decltype(parity_sc_ep4_ep8), decltype(distance_m3)>();
+        }
+
         explicit p1s_solver(u64 _n_thread) : n_thread(_n_thread) {
-            conj_cp = cache_data<array_2d<u16, n_cp, n_s16>>(
+            auto f_conj_cp = cache_data_async<array_2d<u16, n_cp, n_s16>>(
                     "cube3.p1s.conj_cp",
-                    [](array_2d<u16, n_cp, n_s16> &t) -> void {
-                        cube3 a = cube3::i();
-                        for (u64 i = 0; i < n_cp; i++) {
-                            a.cp = int_to_p<8>(i);
-                            for (u64 s = 0; s < n_s16; s++) {
-                                cube3 b = elements_s16[inv_s16[s]] * a * elements_s16[s];
-                                t[i][s] = u16(p_to_int<8>(b.cp));
+                    [this](array_2d<u16, n_cp, n_s16> &t) -> void {
+                        parallel_for(n_cp, n_thread, [&t](u64 start, u64 end) -> void {
+                            cube3 a = cube3::i();
+                            for (u64 i = start; i < end; i++) {
+                                a.cp = int_to_p<8>(i);
+                                for (u64 s = 0; s < n_s16; s++) {
+                                    cube3 b = elements_s16[inv_s16[s]] * a * elements_s16[s];
+                                    t[i][s] = u16(p_to_int<8>(b.cp));
+                                }
                             }
-                        }
+                        });
                     }
             );
-            mul_cp = cache_data<array_2d<u16, n_cp, n_base>>(
+            auto f_mul_cp = cache_data_async<array_2d<u16, n_cp, n_base>>(
                     "cube3.p1s.mul_cp",
                     [](array_2d<u16, n_cp, n_base> &t) -> void {
                         for (u64 i = 0; i < n_cp; i++) {
@@ -475,9 +538,9 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            conj_mul_ep4_ep8 = cache_data<table_conj_mul<u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base>>(
+            auto f_conj_mul_ep4_ep8 = cache_data_async<table_conj_mul<u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base>>(
                     "cube3.p1s.conj_mul_ep4_ep8",
-                    [](table_conj_mul<u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base> &cm) -> void {
+                    [this](table_conj_mul<u32, u16, u16, n_ep4 * n_ep8, n_sc_ep4_ep8, n_s16, n_base> &cm) -> void {
                         cm.init(
                                 [](u32 i) -> std::array<u32, n_s16> {
                                     cube3 a = cube3::i();
@@ -499,11 +562,12 @@ namespace cube::_3::_2p {
                                         mul_i[j] = u32(p_to_int<4>(ep4 * b_ep4) * n_ep8 + p_to_int<8>(ep8 * b_ep8));
                                     }
                                     return mul_i;
-                                }
+                                },
+                                n_thread
                         );
                     }
             );
-            parity_p8 = cache_data<std::array<u8, n_cp>>(
+            auto f_parity_p8 = cache_data_async<std::array<u8, n_cp>>(
                     "cube3.p1s.parity_p8",
                     [](std::array<u8, n_cp> &t) -> void {
                         for (u64 i = 0; i < n_cp; i++) {
@@ -511,21 +575,42 @@ namespace cube::_3::_2p {
                         }
                     }
             );
-            parity_sc_ep4_ep8 = cache_data<std::array<u8, n_sc_ep4_ep8>>(
+            auto f_parity_sc_ep4_ep8 = cache_data_async<std::array<u8, n_sc_ep4_ep8>>(
                     "cube3.p1s.parity_sc_ep4_ep8",
-                    [this](std::array<u8, n_sc_ep4_ep8> &t) -> void {
+                    [f_conj_mul_ep4_ep8, f_parity_p8](std::array<u8, n_sc_ep4_ep8> &t) -> void {
+                        const auto &conj_mul_ep4_ep8 = f_conj_mul_ep4_ep8.get();
+                        const auto &parity_p8 = f_parity_p8.get();
                         for (u64 i = 0; i < n_sc_ep4_ep8; i++) {
                             u64 ep4_ep8 = conj_mul_ep4_ep8->sc_to_g[i];
                             t[i] = u8((*parity_p8)[ep4_ep8 / n_ep8] ^ (*parity_p8)[ep4_ep8 % n_ep8]);
                         }
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            auto f_distance_m3 = cache_data_async<array_u2<n_state>>(
                     "cube3.p1s.distance_m3",
-                    [this](array_u2<n_state> &t) -> void {
-                        bfs<p1s_solver>(*this, t, n_thread);
+                    [_n_thread, f_conj_cp, f_mul_cp, f_conj_mul_ep4_ep8, f_parity_p8, f_parity_sc_ep4_ep8](
+                            array_u2<n_state> &t) -> void {
+                        p1s_solver s(_n_thread, f_conj_cp.get(), f_mul_cp.get(), f_conj_mul_ep4_ep8.get(),
+                                     f_parity_p8.get(), f_parity_sc_ep4_ep8.get());
+                        bfs<p1s_solver>(s, t, _n_thread, "cube3.p1s.distance_m3");
                     }
             );
+            conj_cp = f_conj_cp.get();
+            mul_cp = f_mul_cp.get();
+            conj_mul_ep4_ep8 = f_conj_mul_ep4_ep8.get();
+            parity_p8 = f_parity_p8.get();
+            parity_sc_ep4_ep8 = f_parity_sc_ep4_ep8.get();
+            distance_m3 = freeze(f_distance_m3.get());
+            _start = cube_to_state(t_cube::i());
+        }
+
+        //  a solver of the tables given and no distance table, for the bfs which builds it
+        p1s_solver(u64 _n_thread, decltype(conj_cp) _conj_cp, decltype(mul_cp) _mul_cp,
+                   decltype(conj_mul_ep4_ep8) _conj_mul_ep4_ep8, decltype(parity_p8) _parity_p8,
+                   decltype(parity_sc_ep4_ep8) _parity_sc_ep4_ep8) :
+                n_thread(_n_thread), conj_cp(std::move(_conj_cp)), mul_cp(std::move(_mul_cp)),
+                conj_mul_ep4_ep8(std::move(_conj_mul_ep4_ep8)), parity_p8(std::move(_parity_p8)),
+                parity_sc_ep4_ep8(std::move(_parity_sc_ep4_ep8)) {
             _start = cube_to_state(t_cube::i());
         }
 
@@ -576,12 +661,12 @@ namespace cube::_3::_2p {
             return a_s;
         }
 
-        std::set<u64> alt(const t_state &a, u64 i) const {
+        alt_list alt(const t_state &a, u64 i) const {
             u64 ss = conj_mul_ep4_ep8->sc_to_ss[a.sc_ep4_ep8];
+            alt_list a_i(i);
             if (ss == 1) {
-                return std::set<u64>{i};
+                return a_i;
             }
-            std::set<u64> a_i{};
             for (u64 s = 0; s < n_s16; s++) {
                 if ((ss >> s) & u64(1)) {
                     a_i.insert(state_to_int(t_state{
@@ -604,4 +689,19 @@ namespace cube::_3::_2p {
     typedef combine_solver <p0s_solver, p1s_solver> _2ps_solver;
 }
 
+namespace cube {
+    template<typename _os_e, typename U_SC, u64 _n_sc_egp_eo, const char *name>
+    struct numa_replica<_3::_2p::g_p0s_solver<_os_e, U_SC, _n_sc_egp_eo, name>> {
+        typedef _3::_2p::g_p0s_solver<_os_e, U_SC, _n_sc_egp_eo, name> _solver;
+
+        static _solver call(const _solver &s, u64 node) {
+            _solver r = s;
+            r.conj_mul_egp_eo = cache_replicate(std::string("cube3.") + name + ".conj_mul_egp_eo",
+                                                s.conj_mul_egp_eo, node);
+            r.distance_m3 = cache_replicate(std::string("cube3.") + name + ".distance_m3", s.distance_m3, node);
+            return r;
+        }
+    };
+}
+
 #endif
@@ -2,6 +2,7 @@
 #define _CUBE3_E12_H
 
 #include "base.h"
+#include "cache.h"
 #include "group.h"
 #include "search.h"
 #include "cube3.h"
@@ -19,41 +20,66 @@ namespace cube::_3::e12 {
         array_2d <U_EXT, n_sc, n_base> mul_sc_ext;
 
         void init(const std::function<std::array<std::tuple<U_G, U_EXT>, n_sym>(U_G)> &conj,
-                  const std::function<std::array<U_G, n_base>(U_G)> &mul) {
-            std::vector<bool> mark(n_g, false);
-            u64 k = 0;
-            for (u64 i = 0; i < n_g; i++) {
-                if (not mark[i]) {
+                  const std::function<std::array<U_G, n_base>(U_G)> &mul,
+                  u64 n_thread = 1) {
+            std::vector<U_G> reps = generate_class_representatives<U_G, n_g, n_sym>(
+                    [&conj](U_G i) -> std::array<U_G, n_sym> {
+                        std::array<std::tuple<U_G, U_EXT>, n_sym> conj_i = conj(i);
+                        std::array<U_G, n_sym> conj_g_i{};
+                        for (u64 s = 0; s < n_sym; s++) {
+                            conj_g_i[s] = std::get<0>(conj_i[s]);
+                        }
+                        return conj_g_i;
+                    },
+                    n_thread);
+            assert (reps.size() == n_sc);
+            parallel_for(n_sc, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 k = start; k < end; k++) {
+                    u64 i = reps[k];
                     u64 ss = 0;
-                    std::array<std::tuple<U_G, U_EXT>, n_sym> conj_i = conj(i);
-                    for (u64 s = 0; s < n_sym; s++) {
+                    std::array<std::tuple<U_G, U_EXT>, n_sym> conj_i = conj(U_G(i));
+                    for (u64 s = n_sym - 1; s < n_sym; s--) {
                         auto[j, ext] = conj_i[s];
-                        if (not mark[j]) {
-                            mark[j] = true;
-                            g_to_sym[j] = u8(s);
-                            g_to_sc[j] = U_SC(k);
-                            g_to_ext[j] = ext;
-                        }
+                        g_to_sym[j] = u8(s);
+                        g_to_sc[j] = U_SC(k);
+                        g_to_ext[j] = ext;
                         if (j == i) {
                             ss = ss | (u64(1) << s);
                         }
                     }
                     sc_to_g[k] = U_G(i);
                     sc_to_ss[k] = U_SS(ss);
-                    k++;
                 }
-            }
-            assert (k == n_sc);
-            for (u64 i = 0; i < n_sc; i++) {
-                std::array<U_G, n_base> mul_i = mul(sc_to_g[i]);
-                for (u64 j = 0; j < n_base; j++) {
-                    mul_sc_sym[i][j] = g_to_sym[mul_i[j]];
-                    mul_sc_sc[i][j] = g_to_sc[mul_i[j]];
-                    mul_sc_ext[i][j] = g_to_ext[mul_i[j]];
+            });
+            parallel_for(n_sc, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 i = start; i < end; i++) {
+                    std::array<U_G, n_base> mul_i = mul(sc_to_g[i]);
+                    for (u64 j = 0; j < n_base; j++) {
+                        mul_sc_sym[i][j] = g_to_sym[mul_i[j]];
+                        mul_sc_sc[i][j] = g_to_sc[mul_i[j]];
+                        mul_sc_ext[i][j] = g_to_ext[mul_i[j]];
+                    }
                 }
-            }
+            });
         }
     };
+}
+
+namespace cube {
+    template<typename U_G, typename U_SC, typename U_SS, typename U_EXT, u64 n_g, u64 n_sc, u64 n_sym, u64 n_base>
+    struct type_desc<_3::e12::table_conj_mul_ext<U_G, U_SC, U_SS, U_EXT, n_g, n_sc, n_sym, n_base>> {
+        static std::string name() {
+            return "table_conj_mul_ext<" + type_desc<U_G>::name() + "," + type_desc<U_SC>::name() + ","
+                   + type_desc<U_SS>::name() + "," + type_desc<U_EXT>::name() + ">";
+        }
+
+        static std::vector<u64> shape() {
+            return {n_g, n_sc, n_sym, n_base};
+        }
+    };
+}
+
+namespace cube::_3::e12 {
 
     constexpr u64 inv_eo_fast(u64 eo) {
         return eo;
@@ -89,12 +115,17 @@ namespace cube::_3::e12 {
                 generate_table_conj_base<cube3, n_base, n_s48>(base, elements_s48);
 
         u64 n_thread;
-        std::unique_ptr<array_2d < u16, n_eo, n_s48>> conj_eo;
-        std::unique_ptr<array_2d < u16, n_eo, n_base>> mul_eo;
-        std::unique_ptr<table_conj_mul_ext<u32, u32, u64, u16, n_ep, n_sc_ep, n_s48, n_base>> conj_mul_ep;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<array_2d < u16, n_eo, n_s48>> conj_eo;
+        cache_ptr<array_2d < u16, n_eo, n_base>> mul_eo;
+        cache_ptr<table_conj_mul_ext<u32, u32, u64, u16, n_ep, n_sc_ep, n_s48, n_base>> conj_mul_ep;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
         t_state _start;
 
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(conj_eo), decltype(mul_eo), decltype(conj_mul_ep), decltype(distance_m3)>();
+        }
+
         explicit e12s_solver(u64 _n_thread) : n_thread(_n_thread) {
             conj_eo = cache_data<array_2d<u16, n_eo, n_s48>>(
                     "cube3.e12s.conj_eo",
@@ -142,16 +173,17 @@ namespace cube::_3::e12 {
                                         mul_i[j] = p_to_int<12>(ep * base[j].ep);
                                     }
                                     return mul_i;
-                                }
+                                },
+                                n_thread
                         );
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            distance_m3 = freeze(cache_data<array_u2<n_state>>(
                     "cube3.e12s.distance_m3",
                     [this](array_u2<n_state> &t) -> void {
-                        bfs<e12s_solver>(*this, t, n_thread);
+                        bfs<e12s_solver>(*this, t, n_thread, "cube3.e12s.distance_m3");
                     }
-            );
+            ));
             _start = cube_to_state(t_cube::i());
         }
 
@@ -201,12 +233,12 @@ namespace cube::_3::e12 {
             return a_s;
         }
 
-        std::set<u64> alt(const t_state &a, u64 i) const {
+        alt_list alt(const t_state &a, u64 i) const {
             u64 ss = conj_mul_ep->sc_to_ss[a.sc_ep];
+            alt_list a_i(i);
             if (ss == 1) {
-                return std::set<u64>{i};
+                return a_i;
             }
-            std::set<u64> a_i{};
             for (u64 s = 0; s < n_s48; s++) {
                 if ((ss >> s) & u64(1)) {
                     a_i.insert(state_to_int(t_state{
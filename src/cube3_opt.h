@@ -2,6 +2,7 @@
 #define _CUBE3_OPT_H
 
 #include "base.h"
+#include "cache.h"
 #include "group.h"
 #include "search.h"
 #include "cube3.h"
@@ -54,7 +55,7 @@ namespace cube::_3::opt {
         }
 
         static void init_self_sym_subgroup(
-                std::array<u8, n_state> &self_sym_subgroup, const std::vector<u64> &subgroups_s48) {
+                std::array<u8, n_state> &self_sym_subgroup, const std::vector<u64> &subgroups_s48, u64 n_thread) {
             constexpr u64 n_sc_state = 1841970;
             typedef table_conj_mul<u32, u32, u64, n_state, n_sc_state, n_s48, n_base> t_conj_mul;
             std::unique_ptr<t_conj_mul> conj_mul = std::make_unique<t_conj_mul>();
@@ -72,7 +73,8 @@ namespace cube::_3::opt {
                     },
                     [](u32 i) -> std::array<u32, n_base> {
                         return {};
-                    }
+                    },
+                    n_thread
             );
 
             std::map<u64, std::array<u64, n_s48>> conj_subgroup_s48 =
@@ -81,30 +83,37 @@ namespace cube::_3::opt {
             for (u64 i = 0; i < subgroups_s48.size(); i++) {
                 subgroup_to_int[subgroups_s48[i]] = i;
             }
-            for (u64 i = 0; i < n_state; i++) {
-                auto[sym, sc] = conj_mul->g_to_sym_sc(i);
-                u64 subgroup0 = conj_mul->sc_to_ss[sc];
-                u64 subgroup1 = conj_subgroup_s48.at(subgroup0)[sym];
-                self_sym_subgroup[i] = subgroup_to_int[subgroup1];
-            }
+            parallel_for(n_state, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 i = start; i < end; i++) {
+                    auto[sym, sc] = conj_mul->g_to_sym_sc(i);
+                    u64 subgroup0 = conj_mul->sc_to_ss[sc];
+                    u64 subgroup1 = conj_subgroup_s48.at(subgroup0)[sym];
+                    self_sym_subgroup[i] = subgroup_to_int.at(subgroup1);
+                }
+            });
         }
 
         u64 n_thread;
         std::vector<u64> subgroups_s48;
         std::map<u64, u64> sym_mask;
-        std::unique_ptr<std::array<u8, n_state>> self_sym_subgroup;
-        std::unique_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
-        std::unique_ptr<array_2d < u16, n_co, n_base>> mul_co;
-        std::unique_ptr<array_u2 < n_state>> distance_m3;
+        cache_ptr<std::array<u8, n_state>> self_sym_subgroup;
+        cache_ptr<array_2d < u16, n_cp, n_base>> mul_cp;
+        cache_ptr<array_2d < u16, n_co, n_base>> mul_co;
+        cache_ptr<frozen_u2 < n_state>> distance_m3;
+
+        //  bytes of the tables, the memory the solver needs
+        static constexpr u64 table_memory() {
+            return cache_size<decltype(self_sym_subgroup), decltype(mul_cp), decltype(mul_co), decltype(distance_m3)>();
+        }
 
         explicit c8_solver(u64 _n_thread) : n_thread(_n_thread) {
             subgroups_s48 = generate_table_subgroups<u64, n_s48>(mul_s48);
             sym_mask = generate_table_sym_mask<u64, n_s48, n_base>(subgroups_s48, conj_base);
-            self_sym_subgroup = cache_data<std::array<u8, n_state>>(
+            auto f_self_sym_subgroup = cache_data_async<std::array<u8, n_state>>(
                     "cube3.c8.self_sym_subgroup",
-                    std::bind(&init_self_sym_subgroup, std::placeholders::_1, std::cref(subgroups_s48))
+                    std::bind(&init_self_sym_subgroup, std::placeholders::_1, subgroups_s48, n_thread)
             );
-            mul_cp = cache_data<array_2d<u16, n_cp, n_base>>(
+            auto f_mul_cp = cache_data_async<array_2d<u16, n_cp, n_base>>(
                     "cube3.c8.mul_cp",
                     [](array_2d<u16, n_cp, n_base> &t) -> void {
                         for (u64 i = 0; i < n_cp; i++) {
@@ -115,7 +124,7 @@ namespace cube::_3::opt {
                         }
                     }
             );
-            mul_co = cache_data<array_2d<u16, n_co, n_base>>(
+            auto f_mul_co = cache_data_async<array_2d<u16, n_co, n_base>>(
                     "cube3.c8.mul_co",
                     [](array_2d<u16, n_co, n_base> &t) -> void {
                         for (u64 i = 0; i < n_co; i++) {
@@ -127,12 +136,22 @@ namespace cube::_3::opt {
                         }
                     }
             );
-            distance_m3 = cache_data<array_u2<n_state>>(
+            auto f_distance_m3 = cache_data_async<array_u2<n_state>>(
                     "cube3.c8.distance_m3",
-                    [this](array_u2<n_state> &t) -> void {
-                        bfs<c8_solver>(*this, t, n_thread);
+                    [_n_thread, f_mul_cp, f_mul_co](array_u2<n_state> &t) -> void {
+                        c8_solver s(_n_thread, f_mul_cp.get(), f_mul_co.get());
+                        bfs<c8_solver>(s, t, _n_thread, "cube3.c8.distance_m3");
                     }
             );
+            self_sym_subgroup = f_self_sym_subgroup.get();
+            mul_cp = f_mul_cp.get();
+            mul_co = f_mul_co.get();
+            distance_m3 = freeze(f_distance_m3.get());
+        }
+
+        //  a solver of the tables given and no distance table, for the bfs which builds it
+        c8_solver(u64 _n_thread, decltype(mul_cp) _mul_cp, decltype(mul_co) _mul_co) :
+                n_thread(_n_thread), mul_cp(std::move(_mul_cp)), mul_co(std::move(_mul_co)) {
         }
 
         std::array<t_state, n_base> adj(const t_state &a) const {
@@ -156,6 +175,9 @@ namespace cube::_3::opt {
         }
     };
 
+    constexpr char _c8_exact[] = "cube3.c8.distance_u4";
+    typedef exact_solver<c8_solver, _c8_exact> c8_exact_solver;
+
     template<typename _p0s_solver>
     struct g_opt_solver {
         typedef _p0s_solver p0s_solver;
@@ -183,7 +205,19 @@ namespace cube::_3::opt {
         _p0s_solver p0s_s;
         c8_solver c8_s;
 
-        explicit g_opt_solver(u64 _n_thread) : n_thread(_n_thread), p0s_s(_n_thread), c8_s(_n_thread) {
+        static constexpr u64 table_memory() {
+            return _p0s_solver::table_memory() + c8_solver::table_memory();
+        }
+
+        //  both solvers are built at the same time
+        explicit g_opt_solver(u64 _n_thread) : g_opt_solver(
+                _n_thread,
+                std::async(std::launch::async, [_n_thread]() -> _p0s_solver { return _p0s_solver(_n_thread); }),
+                std::async(std::launch::async, [_n_thread]() -> c8_solver { return c8_solver(_n_thread); })) {
+        }
+
+        g_opt_solver(u64 _n_thread, std::future<_p0s_solver> p0s_f, std::future<c8_solver> c8_f) :
+                n_thread(_n_thread), p0s_s(p0s_f.get()), c8_s(c8_f.get()) {
         }
 
         t_state cube_to_state(const t_cube &a) const {
@@ -331,6 +365,27 @@ namespace cube {
             return s.c8_s.sym_mask.at(subgroup1);
         }
     };
+
+    template<>
+    struct numa_replica<c8_solver> {
+        static c8_solver call(const c8_solver &s, u64 node) {
+            c8_solver r = s;
+            r.distance_m3 = cache_replicate("cube3.c8.distance_m3", s.distance_m3, node);
+            return r;
+        }
+    };
+
+    template<typename _p0s_solver>
+    struct numa_replica<g_opt_solver<_p0s_solver>> {
+        typedef g_opt_solver<_p0s_solver> _solver;
+
+        static _solver call(const _solver &s, u64 node) {
+            _solver r = s;
+            r.p0s_s = numa_replica<_p0s_solver>::call(s.p0s_s, node);
+            r.c8_s = numa_replica<c8_solver>::call(s.c8_s, node);
+            return r;
+        }
+    };
 }
 
 #endif
@@ -479,6 +479,55 @@ namespace cube {
         return t;
     }
 
+    //  smallest element of each conjugacy class of [0, n_g), in increasing order,
+    //  so the index of a class is the one a sequential scan would give it
+    //
+    //  threads claim chunks in order, an element is a representative when none of its conjugates is smaller,
+    //  and the conjugates of a representative are marked so the rest of its class is skipped
+    template<typename U_G, u64 n_g, u64 n_sym>
+    std::vector<U_G> generate_class_representatives(
+            const std::function<std::array<U_G, n_sym>(U_G)> &conj, u64 n_thread) {
+        constexpr u64 chunk_size = u64(1) << 16;
+        constexpr u64 n_chunk = (n_g + chunk_size - 1) / chunk_size;
+        std::vector<std::atomic<u64>> mark((n_g + 63) / 64);
+        std::vector<std::vector<U_G>> chunk_reps(n_chunk);
+        std::atomic<u64> next_chunk{0};
+        auto work = [&]() -> void {
+            for (u64 c = next_chunk++; c < n_chunk; c = next_chunk++) {
+                u64 end = std::min((c + 1) * chunk_size, n_g);
+                for (u64 i = c * chunk_size; i < end; i++) {
+                    if ((mark[i / 64].load(std::memory_order_relaxed) >> (i % 64)) & 1) {
+                        continue;
+                    }
+                    std::array<U_G, n_sym> conj_i = conj(U_G(i));
+                    bool is_rep = true;
+                    for (u64 s = 0; s < n_sym; s++) {
+                        is_rep = is_rep and conj_i[s] >= i;
+                    }
+                    if (is_rep) {
+                        chunk_reps[c].push_back(U_G(i));
+                        for (u64 s = 0; s < n_sym; s++) {
+                            u64 j = conj_i[s];
+                            mark[j / 64].fetch_or(u64(1) << (j % 64), std::memory_order_relaxed);
+                        }
+                    }
+                }
+            }
+        };
+        std::vector<std::future<void>> future{};
+        for (u64 i = 0; i < n_thread; i++) {
+            future.push_back(std::async(std::launch::async, work));
+        }
+        for (u64 i = 0; i < n_thread; i++) {
+            future[i].get();
+        }
+        std::vector<U_G> reps{};
+        for (u64 c = 0; c < n_chunk; c++) {
+            reps.insert(reps.end(), chunk_reps[c].begin(), chunk_reps[c].end());
+        }
+        return reps;
+    }
+
     template<typename U_G, typename U_SC, typename U_SS, u64 n_g, u64 n_sc, u64 n_sym, u64 n_base>
     struct table_conj_mul {
         std::array<u8, n_g> g_to_sym;
@@ -489,43 +538,55 @@ namespace cube {
         array_2d <U_SC, n_sc, n_base> mul_sc_sc;
 
         void init(const std::function<std::array<U_G, n_sym>(U_G)> &conj,
-                  const std::function<std::array<U_G, n_base>(U_G)> &mul) {
-            std::vector<bool> mark(n_g, false);
-            u64 k = 0;
-            for (u64 i = 0; i < n_g; i++) {
-                if (not mark[i]) {
+                  const std::function<std::array<U_G, n_base>(U_G)> &mul,
+                  u64 n_thread = 1) {
+            std::vector<U_G> reps = generate_class_representatives<U_G, n_g, n_sym>(conj, n_thread);
+            assert (reps.size() == n_sc);
+            parallel_for(n_sc, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 k = start; k < end; k++) {
+                    u64 i = reps[k];
                     u64 ss = 0;
-                    std::array<U_G, n_sym> conj_i = conj(i);
-                    for (u64 s = 0; s < n_sym; s++) {
+                    std::array<U_G, n_sym> conj_i = conj(U_G(i));
+                    //  backwards, so the smallest symmetry reaching an element is the one kept
+                    for (u64 s = n_sym - 1; s < n_sym; s--) {
                         u64 j = conj_i[s];
-                        if (not mark[j]) {
-                            mark[j] = true;
-                            g_to_sym[j] = u8(s);
-                            g_to_sc[j] = U_SC(k);
-                        }
+                        g_to_sym[j] = u8(s);
+                        g_to_sc[j] = U_SC(k);
                         if (j == i) {
                             ss = ss | (u64(1) << s);
                         }
                     }
                     sc_to_g[k] = U_G(i);
                     sc_to_ss[k] = U_SS(ss);
-                    k++;
                 }
-            }
-            assert (k == n_sc);
-            for (u64 i = 0; i < n_sc; i++) {
-                std::array<U_G, n_base> mul_i = mul(sc_to_g[i]);
-                for (u64 j = 0; j < n_base; j++) {
-                    mul_sc_sym[i][j] = g_to_sym[mul_i[j]];
-                    mul_sc_sc[i][j] = g_to_sc[mul_i[j]];
+            });
+            parallel_for(n_sc, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 i = start; i < end; i++) {
+                    std::array<U_G, n_base> mul_i = mul(sc_to_g[i]);
+                    for (u64 j = 0; j < n_base; j++) {
+                        mul_sc_sym[i][j] = g_to_sym[mul_i[j]];
+                        mul_sc_sc[i][j] = g_to_sc[mul_i[j]];
+                    }
                 }
-            }
+            });
         }
 
-        std::tuple<u8, U_SC> g_to_sym_sc(U_G g) {
+        std::tuple<u8, U_SC> g_to_sym_sc(U_G g) const {
             return {g_to_sym[g], g_to_sc[g]};
         }
     };
+
+    template<typename U_G, typename U_SC, typename U_SS, u64 n_g, u64 n_sc, u64 n_sym, u64 n_base>
+    struct type_desc<table_conj_mul<U_G, U_SC, U_SS, n_g, n_sc, n_sym, n_base>> {
+        static std::string name() {
+            return "table_conj_mul<" + type_desc<U_G>::name() + "," + type_desc<U_SC>::name() + ","
+                   + type_desc<U_SS>::name() + ">";
+        }
+
+        static std::vector<u64> shape() {
+            return {n_g, n_sc, n_sym, n_base};
+        }
+    };
 }
 
 #endif
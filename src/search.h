@@ -1,9 +1,106 @@
 #ifndef _SEARCH_H
 #define _SEARCH_H
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 #include "base.h"
+#include "cache.h"
 
 namespace cube {
+    //  xor with _u2_modify[x] turns the 2 bit entries equal to x into 3
+    constexpr std::array<u64, 4> _u2_modify{
+            0xffffffffffffffff,
+            0xaaaaaaaaaaaaaaaa,
+            0x5555555555555555,
+            0x0000000000000000
+    };
+
+    constexpr u64 _u2_low = 0x5555555555555555;
+
+    //  the low bit of each entry of y equal to x
+    constexpr u64 _match_u2(u64 y, u64 x) {
+        u64 z = y ^_u2_modify[x];
+        return (z >> u64(1)) & z & _u2_low;
+    }
+
+    //  the first word in [w, w_end) with an entry equal to x, or w_end
+    inline u64 _find_u2_scalar(const u64 *p, u64 w, u64 w_end, u64 x) {
+        for (; w < w_end; w++) {
+            if (_match_u2(p[w], x) != 0) {
+                return w;
+            }
+        }
+        return w_end;
+    }
+
+#if defined(__x86_64__)
+    //  4 and 8 words at a time, the word found in a group is left to the scalar one
+    __attribute__((target("avx2")))
+    inline u64 _find_u2_avx2(const u64 *p, u64 w, u64 w_end, u64 x) {
+        const __m256i modify = _mm256_set1_epi64x(static_cast<long long>(_u2_modify[x]));
+        const __m256i low = _mm256_set1_epi64x(static_cast<long long>(_u2_low));
+        for (; w + 4 <= w_end; w += 4) {
+            __m256i y = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + w)), modify);
+            __m256i z = _mm256_and_si256(_mm256_srli_epi64(y, 1), y);
+            if (not _mm256_testz_si256(z, low)) {
+                break;
+            }
+        }
+        return _find_u2_scalar(p, w, w_end, x);
+    }
+
+    __attribute__((target("avx512f")))
+    inline u64 _find_u2_avx512(const u64 *p, u64 w, u64 w_end, u64 x) {
+        const __m512i modify = _mm512_set1_epi64(static_cast<long long>(_u2_modify[x]));
+        const __m512i low = _mm512_set1_epi64(static_cast<long long>(_u2_low));
+        for (; w + 8 <= w_end; w += 8) {
+            __m512i y = _mm512_xor_si512(_mm512_loadu_si512(p + w), modify);
+            __m512i z = _mm512_and_si512(_mm512_maskz_srli_epi64(0xff, y, 1), y);
+            if (_mm512_test_epi64_mask(z, low) != 0) {
+                break;
+            }
+        }
+        return _find_u2_scalar(p, w, w_end, x);
+    }
+
+    __attribute__((target("xsave")))
+    inline u64 _xcr0() {
+        return _xgetbv(0);
+    }
+#endif
+
+    //  the widest scan the cpu and the os support, picked once
+    struct _u2_scanner {
+        const char *isa;
+        u64 (*find)(const u64 *, u64, u64, u64);
+
+        static _u2_scanner select() {
+#if defined(__x86_64__)
+            unsigned a, b, c, d;
+            if (__get_cpuid(1, &a, &b, &c, &d) and (c & bit_OSXSAVE) and (c & bit_AVX)
+                and __get_cpuid_count(7, 0, &a, &b, &c, &d)) {
+                u64 xcr0 = _xcr0();
+                if ((b & bit_AVX512F) and (xcr0 & 0xe6) == 0xe6) {
+                    return {"avx512", _find_u2_avx512};
+                }
+                if ((b & bit_AVX2) and (xcr0 & 0x6) == 0x6) {
+                    return {"avx2", _find_u2_avx2};
+                }
+            }
+#endif
+            return {"scalar", _find_u2_scalar};
+        }
+    };
+
+    inline const _u2_scanner u2_scanner = _u2_scanner::select();
+
     template<u64 _size>
     struct array_u2 {
         std::array<std::atomic_uint64_t, (_size + 31) / 32> a;
@@ -18,6 +115,13 @@ namespace cube {
             return (a[j] >> k) & u64(3);
         }
 
+        //  hint the word of i into the cache ahead of a get or compare_and_set
+        void prefetch(u64 i) const {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(&a[i / 32]);
+#endif
+        }
+
         bool compare_and_set(u64 i, u64 old_x, u64 new_x) {
             u64 j = i / 32;
             u64 k = i % 32 * 2;
@@ -31,6 +135,38 @@ namespace cube {
             return false;
         }
 
+        //  a load and a store of the word of i without a compare and swap,
+        //  only for a thread which no other thread writes the word with at the same time
+        void set(u64 i, u64 x) {
+            u64 j = i / 32;
+            u64 k = i % 32 * 2;
+            u64 y = a[j].load(std::memory_order_relaxed);
+            a[j].store((y & ~(u64(3) << k)) | (x << k), std::memory_order_relaxed);
+        }
+
+        //  f(j) for each j in [start, end) whose entry is x, in order,
+        //  the words are searched by u2_scanner and the entries of a word found by counting trailing zeros,
+        //  an entry another thread sets meanwhile may be seen before or after it is set
+        template<typename F>
+        void scan(u64 start, u64 end, u64 x, const F &f) const {
+            static_assert(sizeof(std::atomic_uint64_t) == sizeof(u64));
+            const u64 *p = reinterpret_cast<const u64 *>(a.data());
+            u64 w_start = start / 32;
+            u64 w_end = (end + 31) / 32;
+            for (u64 w = u2_scanner.find(p, w_start, w_end, x); w < w_end; w = u2_scanner.find(p, w + 1, w_end, x)) {
+                u64 m = _match_u2(a[w].load(std::memory_order_relaxed), x);
+                if (w == w_start) {
+                    m &= ~u64(0) << (start % 32 * 2);
+                }
+                if (end < w * 32 + 32) {
+                    m &= (u64(1) << ((end - w * 32) * 2)) - 1;
+                }
+                for (; m != 0; m &= m - 1) {
+                    f(w * 32 + u64(__builtin_ctzll(m)) / 2);
+                }
+            }
+        }
+
         void fill(u64 x) {
             u64 y = x;
             for (u64 i = 1; i < 6; i++) {
@@ -42,153 +178,1038 @@ namespace cube {
         }
     };
 
-    std::vector<u64> _split(u64 m, u64 n) {
-        u64 mm = (m + 31) / 32;
-        u64 div = mm / n;
-        u64 mod = mm % n;
-        std::vector<u64> sp{0};
-        for (u64 i = 0; i < n; i++) {
-            sp.push_back(std::min(sp[i] + (div + (i < mod ? 1 : 0)) * 32, m));
+    template<u64 _size>
+    struct type_desc<array_u2<_size>> {
+        static std::string name() {
+            return "array_u2";
+        }
+
+        static std::vector<u64> shape() {
+            return {_size};
+        }
+    };
+
+    //  a word of a frozen_u2, which the compiler must assume may alias the atomic word of array_u2 it was written as
+#if defined(__GNUC__) || defined(__clang__)
+    typedef u64 __attribute__((__may_alias__)) _u64_alias;
+#else
+    typedef u64 _u64_alias;
+#endif
+
+    //  an array_u2 once its bfs is done, in the same words without atomics, so the reads of a search
+    //  can be hoisted, combined and vectorized by the compiler
+    template<u64 _size>
+    struct frozen_u2 {
+        _u64_alias a[(_size + 31) / 32];
+
+        constexpr u64 size() const {
+            return _size;
         }
-        return sp;
+
+        u64 get(u64 i) const {
+            u64 j = i / 32;
+            u64 k = i % 32 * 2;
+            return (a[j] >> k) & u64(3);
+        }
+
+        void prefetch(u64 i) const {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(&a[i / 32]);
+#endif
+        }
+    };
+
+    //  the table of p as a frozen_u2, sharing its memory, p must not be written any more,
+    //  the words are read as u64 where they were written as std::atomic_uint64_t, which is only sound
+    //  when the atomic is a lock free u64 of the same size and alignment, so with no lock or padding in the words,
+    //  and when the compiler does not assume the two types never alias, which _u64_alias tells gcc and clang
+    template<u64 _size>
+    cache_ptr<frozen_u2<_size>> freeze(const cache_ptr<array_u2<_size>> &p) {
+        static_assert(sizeof(frozen_u2<_size>) == sizeof(array_u2<_size>));
+        static_assert(sizeof(std::atomic_uint64_t) == sizeof(u64) and std::atomic_uint64_t::is_always_lock_free);
+        static_assert(alignof(std::atomic_uint64_t) == alignof(u64));
+        return cache_ptr<frozen_u2<_size>>(p, reinterpret_cast<const frozen_u2<_size> *>(p.get()));
     }
 
+    //  exact distances in 4 bits, 15 for a state not reached yet, so distances up to 14,
+    //  written by one thread a word and not while it is read, so the words are plain
+    template<u64 _size>
+    struct array_u4 {
+        static constexpr u64 unset = 15;
+
+        std::array<u64, (_size + 15) / 16> a;
+
+        constexpr u64 size() const {
+            return _size;
+        }
+
+        u64 get(u64 i) const {
+            u64 j = i / 16;
+            u64 k = i % 16 * 4;
+            return (a[j] >> k) & u64(15);
+        }
+
+        void fill(u64 x) {
+            u64 y = x;
+            for (u64 i = 2; i < 6; i++) {
+                y = y | (y << (u64(1) << i));
+            }
+            std::fill(a.begin(), a.end(), y);
+        }
+    };
+
+    template<u64 _size>
+    struct type_desc<array_u4<_size>> {
+        static std::string name() {
+            return "array_u4";
+        }
+
+        static std::vector<u64> shape() {
+            return {_size};
+        }
+    };
+
+    //  states equal to one state under its self symmetries, at most 48 without duplicates,
+    //  held in place so the bfs does not allocate for each state it sets
+    struct alt_list {
+        static constexpr u64 capacity = 48;
+
+        u64 n;
+        std::array<u64, capacity> a;
+
+        explicit alt_list(u64 i) : n(1) {
+            a[0] = i;
+        }
+
+        void insert(u64 i) {
+            for (u64 k = 0; k < n; k++) {
+                if (a[k] == i) {
+                    return;
+                }
+            }
+            assert(n < capacity);
+            a[n++] = i;
+        }
+
+        u64 size() const {
+            return n;
+        }
+
+        const u64 *begin() const {
+            return &a[0];
+        }
+
+        const u64 *end() const {
+            return &a[0] + n;
+        }
+    };
+
+    //  another thread may be setting the same set from another of its states, so each state is counted by the
+    //  thread which set it, and the set by the thread which set its smallest state,
+    //  returns the number of states set and whether the smallest is one of them
     template<u64 _size, typename C>
-    u64 _set_multi(array_u2<_size> &distance_m3, const C &i_s, u64 old_x, u64 new_x) {
+    std::tuple<u64, bool> _set_multi(array_u2<_size> &distance_m3, const C &i_s, u64 old_x, u64 new_x) {
         auto it = i_s.begin();
         if (not distance_m3.compare_and_set(*it, old_x, new_x)) {
-            return 0;
+            return {0, false};
+        }
+        if (i_s.size() == 1) {
+            return {1, true};
         }
+        u64 i_min = *std::min_element(i_s.begin(), i_s.end());
+        u64 count = 1;
+        bool is_min = *it == i_min;
         ++it;
         auto last = i_s.end();
         while (it != last) {
-            assert(distance_m3.compare_and_set(*it, old_x, new_x));
+            if (distance_m3.compare_and_set(*it, old_x, new_x)) {
+                count++;
+                is_min = is_min or *it == i_min;
+            }
             ++it;
         }
-        return i_s.size();
+        return {count, is_min};
     }
 
-    template<typename _solver>
-    std::tuple<u64, u64> _forward(const _solver &s, array_u2<_solver::n_state> &distance_m3,
-                                  u64 start, u64 end, u64 prev_depth_m3, u64 depth_m3) {
-        constexpr std::array<u64, 3> modify{
-                0xffffffffffffffff,
-                0xaaaaaaaaaaaaaaaa,
-                0x5555555555555555
+    //  the neighbors of a batch of states are gathered and their words prefetched before any is read,
+    //  so the cache misses of a batch overlap instead of being waited for one by one
+    constexpr u64 _bfs_batch = 32;
+
+    //  visit(b, k) is called for each neighbor k of the frontier in [start, end) which was unset when read,
+    //  b is its state as adj gives it, returns the number of states in the frontier
+    template<typename _solver, typename F>
+    u64 _forward(const _solver &s, const array_u2<_solver::n_state> &distance_m3,
+                  u64 start, u64 end, u64 prev_depth_m3, const F &visit) {
+        constexpr u64 n_neighbor = _bfs_batch * _solver::n_base;
+        std::array<typename _solver::t_state, n_neighbor> b_s;
+        std::array<u64, n_neighbor> k_s;
+        u64 n = 0;
+        u64 scanned = 0;
+        auto update = [&]() -> void {
+            for (u64 x = 0; x < n; x++) {
+                if (distance_m3.get(k_s[x]) == 3) {
+                    visit(b_s[x], k_s[x]);
+                }
+            }
+            n = 0;
         };
-        constexpr u64 mask = 0x5555555555555555;
+        distance_m3.scan(start, end, prev_depth_m3, [&](u64 j) -> void {
+            scanned++;
+            typename _solver::t_state a = s.int_to_state(j);
+            for (typename _solver::t_state b: s.adj(a)) {
+                u64 k = s.state_to_int(b);
+                distance_m3.prefetch(k);
+                b_s[n] = b;
+                k_s[n] = k;
+                n++;
+            }
+            if (n == n_neighbor) {
+                update();
+            }
+        });
+        update();
+        return scanned;
+    }
+
+    //  visit(a, j) is called for each state j in [start, end) which was unset and has a neighbor in the frontier,
+    //  returns the number of unset states
+    template<typename _solver, typename F>
+    u64 _backward(const _solver &s, const array_u2<_solver::n_state> &distance_m3,
+                   u64 start, u64 end, u64 prev_depth_m3, const F &visit) {
+        constexpr u64 n_base = _solver::n_base;
+        std::array<typename _solver::t_state, _bfs_batch> a_s;
+        std::array<u64, _bfs_batch> j_s;
+        std::array<u64, _bfs_batch * n_base> k_s;
+        u64 n = 0;
+        u64 scanned = 0;
+        auto update = [&]() -> void {
+            for (u64 y = 0; y < n; y++) {
+                for (u64 x = 0; x < n_base; x++) {
+                    if (distance_m3.get(k_s[y * n_base + x]) == prev_depth_m3) {
+                        visit(a_s[y], j_s[y]);
+                        break;
+                    }
+                }
+            }
+            n = 0;
+        };
+        distance_m3.scan(start, end, 3, [&](u64 j) -> void {
+            scanned++;
+            typename _solver::t_state a = s.int_to_state(j);
+            u64 x_k = n * n_base;
+            for (typename _solver::t_state b: s.adj(a)) {
+                u64 k = s.state_to_int(b);
+                distance_m3.prefetch(k);
+                k_s[x_k++] = k;
+            }
+            a_s[n] = a;
+            j_s[n] = j;
+            n++;
+            if (n == _bfs_batch) {
+                update();
+            }
+        });
+        update();
+        return scanned;
+    }
+
+    //  work of one thread at a depth, scanned is the frontier read forward or the unset states read backward,
+    //  cas_fail the states found unset whose compare and swap lost, there is none in a partitioned depth
+    struct bfs_thread_stat {
+        u64 scanned = 0;
         u64 count_distinct = 0;
         u64 count = 0;
-        for (u64 i = start; i < end; i += 32) {
-            u64 x = distance_m3.a[i / 32] ^modify[prev_depth_m3];
-            if (((x >> u64(1)) & x & mask) == 0) {
-                continue;
-            }
-            u64 j_end = std::min(i + 32, end);
-            for (u64 j = i; j < j_end; j++) {
-                if (distance_m3.get(j) == prev_depth_m3) {
-                    typename _solver::t_state a = s.int_to_state(j);
-                    for (typename _solver::t_state b: s.adj(a)) {
-                        u64 k = s.state_to_int(b);
-                        if (distance_m3.get(k) == 3) {
-                            u64 c = _set_multi<_solver::n_state>(distance_m3, s.alt(b, k), 3, depth_m3);
-                            if (c > 0) {
-                                count_distinct++;
-                                count += c;
+        u64 cas_fail = 0;
+        double time = 0.0;
+    };
+
+    //  fields of a JSON object, numbers as they are and strings quoted
+    struct _json_fields {
+        std::ostringstream s;
+
+        template<typename T>
+        _json_fields &operator()(const std::string &key, const T &value) {
+            s << (s.tellp() > 0 ? "," : "") << "\"" << key << "\":" << value;
+            return *this;
+        }
+
+        _json_fields &operator()(const std::string &key, const std::string &value) {
+            s << (s.tellp() > 0 ? "," : "") << "\"" << key << "\":\"" << value << "\"";
+            return *this;
+        }
+
+        _json_fields &operator()(const std::string &key, const char *value) {
+            return (*this)(key, std::string(value));
+        }
+
+        //  value is already JSON
+        _json_fields &raw(const std::string &key, const std::string &value) {
+            s << (s.tellp() > 0 ? "," : "") << "\"" << key << "\":" << value;
+            return *this;
+        }
+
+        std::string str() const {
+            return s.str();
+        }
+    };
+
+    //  with cache_options.bfs_telemetry, a bfs building a table appends one JSON object per line to
+    //  "cache/<name>.bfs.jsonl" along the lines it prints, "start", "depth" with the work of each thread,
+    //  "decision" with the estimated cost of each direction, "progress" within a depth every
+    //  cache_options.bfs_progress seconds, "checkpoint" and "end"
+    struct bfs_telemetry {
+        std::string name;
+        std::unique_ptr<std::ofstream> f;
+        std::mutex mutex;
+
+        explicit bfs_telemetry(const std::string &_name) : name(_name) {
+            if (not _name.empty() and cache_options.bfs_telemetry) {
+                std::filesystem::create_directory("cache/");
+                f = std::make_unique<std::ofstream>("cache/" + _name + ".bfs.jsonl", std::ios::app);
+            }
+        }
+
+        void write(const std::string &event, const _json_fields &fields) {
+            if (f == nullptr) {
+                return;
+            }
+            std::chrono::duration<double> now = std::chrono::system_clock::now().time_since_epoch();
+            std::lock_guard<std::mutex> lock(mutex);
+            *f << std::fixed << std::setprecision(3) << "{\"event\":\"" << event << "\",\"table\":\"" << name
+               << "\",\"unix_time\":" << now.count() << std::defaultfloat << std::setprecision(6)
+               << (fields.str().empty() ? "" : ",") << fields.str() << "}" << std::endl;
+        }
+
+        void write_depth(u64 depth, const std::string &direction, u64 count_distinct, u64 count, u64 total_count,
+                         double time, const std::vector<bfs_thread_stat> &stats) {
+            std::string threads = "[";
+            for (const bfs_thread_stat &x: stats) {
+                _json_fields t{};
+                t("scanned", x.scanned)("count_distinct", x.count_distinct)("count", x.count)
+                        ("cas_fail", x.cas_fail)("time", x.time);
+                threads += (threads.size() > 1 ? ",{" : "{") + t.str() + "}";
+            }
+            threads += "]";
+            write("depth", _json_fields{}("depth", depth)("direction", direction)("count_distinct", count_distinct)
+                    ("count", count)("total_count", total_count)("time", time).raw("threads", threads));
+        }
+    };
+
+    //  partitioned depth, each thread owns a contiguous range of whole words of the table and is the only one
+    //  writing it, so states are set without compare and swap
+    //
+    //  a depth goes in rounds over a slice of each range, and a round is up to three runs of the pool
+    //  scan     forward, the neighbors of the frontier in the slice still unset go to the buffer of their owner,
+    //           backward, the unset states in the slice with a neighbor in the frontier are set
+    //  apply    forward, each owner sets the states in the buffers sent to it
+    //  alt      each owner sets the alternatives of those states sent to it by other owners,
+    //           the top bit marks the smallest state of a set, so count_distinct counts the sets as with compare and swap
+    //
+    //  a run of the pool ends before the next starts, so no state is read in a word another thread is writing,
+    //  except the neighbors read by backward, whose value at the previous depth does not change
+    constexpr u64 _bfs_owner_min_flag = u64(1) << 63;
+    constexpr u64 _bfs_round_size = u64(1) << 18;
+
+    //  progress(done) is called after each round with the part of the table scanned
+    template<typename _solver>
+    void _bfs_partitioned(const _solver &s, array_u2<_solver::n_state> &distance_m3, worker_pool &pool,
+                          u64 prev_depth_m3, u64 depth_m3, bool backward, std::vector<bfs_thread_stat> &stats,
+                          const std::function<void(double)> &progress) {
+        constexpr u64 n_state = _solver::n_state;
+        constexpr u64 n_word = (n_state + 31) / 32;
+        u64 n_thread = pool.size();
+        u64 range_size = (n_word + n_thread - 1) / n_thread * 32;
+        std::vector<u64> cursor(n_thread);
+        std::vector<u64> range_end(n_thread);
+        for (u64 t = 0; t < n_thread; t++) {
+            cursor[t] = std::min(t * range_size, n_state);
+            range_end[t] = std::min((t + 1) * range_size, n_state);
+        }
+        std::vector<std::vector<std::vector<u64>>> sent(n_thread, std::vector<std::vector<u64>>(n_thread));
+        std::vector<std::vector<std::vector<u64>>> sent_alt(n_thread, std::vector<std::vector<u64>>(n_thread));
+
+        auto timed = [&stats](u64 t, const std::function<void()> &f) -> void {
+            auto b0 = std::chrono::steady_clock::now();
+            f();
+            auto b1 = std::chrono::steady_clock::now();
+            std::chrono::duration<double> b = b1 - b0;
+            stats[t].time += b.count();
+        };
+
+        //  i is owned by t, its alternatives in the range of t are set too, the others are sent to their owner
+        auto set = [&](u64 t, u64 i) -> void {
+            u64 &cd = stats[t].count_distinct;
+            u64 &c = stats[t].count;
+            if (distance_m3.get(i) != 3) {
+                return;
+            }
+            distance_m3.set(i, depth_m3);
+            c++;
+            auto i_s = s.alt(s.int_to_state(i), i);
+            if (i_s.size() == 1) {
+                cd++;
+                return;
+            }
+            u64 i_min = *std::min_element(i_s.begin(), i_s.end());
+            cd += i == i_min;
+            for (u64 j: i_s) {
+                if (j == i) {
+                    continue;
+                }
+                u64 o = j / range_size;
+                if (o != t) {
+                    sent_alt[t][o].push_back(j | (j == i_min ? _bfs_owner_min_flag : 0));
+                } else if (distance_m3.get(j) == 3) {
+                    distance_m3.set(j, depth_m3);
+                    c++;
+                    cd += j == i_min;
+                }
+            }
+        };
+
+        bool more = true;
+        while (more) {
+            pool.run([&](u64 t) -> void {
+                timed(t, [&]() -> void {
+                    u64 start = cursor[t];
+                    u64 end = std::min(start + _bfs_round_size, range_end[t]);
+                    cursor[t] = end;
+                    if (backward) {
+                        stats[t].scanned += _backward<_solver>(
+                                s, distance_m3, start, end, prev_depth_m3,
+                                [&](const typename _solver::t_state &, u64 j) -> void {
+                                    set(t, j);
+                                });
+                    } else {
+                        stats[t].scanned += _forward<_solver>(
+                                s, distance_m3, start, end, prev_depth_m3,
+                                [&](const typename _solver::t_state &, u64 k) -> void {
+                                    sent[t][k / range_size].push_back(k);
+                                });
+                    }
+                });
+            });
+            if (not backward) {
+                pool.run([&](u64 t) -> void {
+                    timed(t, [&]() -> void {
+                        for (u64 f = 0; f < n_thread; f++) {
+                            for (u64 k: sent[f][t]) {
+                                set(t, k);
                             }
+                            sent[f][t].clear();
                         }
+                    });
+                });
+            }
+            pool.run([&](u64 t) -> void {
+                timed(t, [&]() -> void {
+                    u64 &cd = stats[t].count_distinct;
+                    u64 &c = stats[t].count;
+                    for (u64 f = 0; f < n_thread; f++) {
+                        for (u64 r: sent_alt[f][t]) {
+                            u64 j = r & ~_bfs_owner_min_flag;
+                            if (distance_m3.get(j) == 3) {
+                                distance_m3.set(j, depth_m3);
+                                c++;
+                                cd += (r & _bfs_owner_min_flag) != 0;
+                            }
+                        }
+                        sent_alt[f][t].clear();
                     }
+                });
+            });
+            more = false;
+            u64 left = 0;
+            for (u64 t = 0; t < n_thread; t++) {
+                more = more or cursor[t] < range_end[t];
+                left += range_end[t] - cursor[t];
+            }
+            progress(double(n_state - left) / double(n_state));
+        }
+    }
+
+    //  seconds per state read of the two passes, forward per state of the frontier and backward per unset state,
+    //  taken from the last depth run in each direction, or from a sample of the chunks run both ways without setting
+    //  any state, an unmeasured pass costs as much as the other, so the first choice is the one by counts
+    struct bfs_cost_model {
+        double forward = 0.0;
+        double backward = 0.0;
+        bool sampled = false;
+
+        std::tuple<double, double> estimate(u64 frontier, u64 unset) const {
+            double f = forward > 0.0 ? forward : backward > 0.0 ? backward : 1.0;
+            double b = backward > 0.0 ? backward : f;
+            return {f * double(frontier), b * double(unset)};
+        }
+
+        void update(bool is_backward, const std::vector<bfs_thread_stat> &stats) {
+            double time = 0.0;
+            u64 scanned = 0;
+            for (const bfs_thread_stat &x: stats) {
+                time += x.time;
+                scanned += x.scanned;
+            }
+            if (scanned > 0) {
+                (is_backward ? backward : forward) = time / double(scanned);
+            }
+        }
+    };
+
+    //  the sample is taken once, at the first depth with fewer than _bfs_sample_ratio unset states a frontier state
+    constexpr u64 _bfs_sample_stride = 64;
+    constexpr u64 _bfs_sample_ratio = 4;
+
+    //  _forward and _backward on every stride-th chunk with a visit which sets nothing, seconds per state read,
+    //  the visit still looks up the alternatives, which costs as much as the compare and swap of a real one,
+    //  the first chunk is random so that repeated builds do not always time the same states
+    template<typename _solver>
+    std::tuple<double, double> _bfs_sample(const _solver &s, const array_u2<_solver::n_state> &distance_m3,
+                                           worker_pool &pool, u64 prev_depth_m3, u64 chunk_size, u64 stride) {
+        constexpr u64 n_state = _solver::n_state;
+        u64 n_chunk = (n_state + chunk_size - 1) / chunk_size;
+        u64 offset = std::random_device{}() % std::min(stride, n_chunk);
+        std::array<double, 2> result{};
+        for (u64 is_backward = 0; is_backward < 2; is_backward++) {
+            std::atomic<u64> next_chunk{0};
+            std::vector<bfs_thread_stat> stats(pool.size());
+            pool.run([&](u64 t) -> void {
+                auto b0 = std::chrono::steady_clock::now();
+                auto visit = [&](const typename _solver::t_state &a, u64 i) -> void {
+                    stats[t].count += s.alt(a, i).size();
+                };
+                for (u64 k = offset + next_chunk++ * stride; k < n_chunk; k = offset + next_chunk++ * stride) {
+                    u64 start = k * chunk_size;
+                    u64 end = std::min(start + chunk_size, n_state);
+                    stats[t].scanned += is_backward ?
+                                        _backward<_solver>(s, distance_m3, start, end, prev_depth_m3, visit) :
+                                        _forward<_solver>(s, distance_m3, start, end, prev_depth_m3, visit);
                 }
+                auto b1 = std::chrono::steady_clock::now();
+                std::chrono::duration<double> b = b1 - b0;
+                stats[t].time = b.count();
+            });
+            bfs_cost_model m{};
+            m.update(is_backward, stats);
+            result[is_backward] = is_backward ? m.backward : m.forward;
+        }
+        return {result[0], result[1]};
+    }
+
+    //  state of a bfs after a depth, saved with the partial table in "cache/<name>.checkpoint"
+    struct bfs_checkpoint {
+        u64 n_state;
+        u64 depth;
+        u64 total_count_distinct;
+        u64 total_count;
+        std::array<u64, 3> count_m3;
+    };
+
+    template<>
+    struct type_desc<bfs_checkpoint> {
+        static std::string name() {
+            return "bfs_checkpoint";
+        }
+
+        static std::vector<u64> shape() {
+            return {};
+        }
+    };
+
+    template<u64 _size>
+    void _bfs_save(const std::string &name, const bfs_checkpoint &c, const array_u2<_size> &distance_m3,
+                   u64 n_thread) {
+        auto t0 = std::chrono::steady_clock::now();
+        std::filesystem::create_directory("cache/");
+        std::vector<cache_section> sections{
+                make_cache_section<bfs_checkpoint>(name + ".checkpoint", c),
+                make_cache_section<array_u2<_size>>(name + ".checkpoint.table", distance_m3)
+        };
+        for (cache_section &section: sections) {
+            section.codec = cache_codec_none;
+        }
+        write_cache_file("cache/" + name + ".checkpoint", sections, n_thread);
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t1 - t0;
+        std::cout << "bfs: checkpoint " << name << ", depth=" << c.depth << ", time=" << d.count() << "s"
+                  << std::endl;
+    }
+
+    //  the sections are found as a bundle, so their type and size are checked as for a cache file
+    template<u64 _size>
+    bool _bfs_load(const std::string &name, bfs_checkpoint &c, array_u2<_size> &distance_m3, u64 n_thread) {
+        auto[c_found, c_error, c_path, c_section] =
+                _cache_find<bfs_checkpoint>("cache/", name + ".checkpoint");
+        auto[t_found, t_error, t_path, t_section] =
+                _cache_find<array_u2<_size>>("cache/", name + ".checkpoint.table");
+        if (not c_found or not t_found or not c_error.empty() or not t_error.empty()
+            or c_section.codec != cache_codec_none or t_section.codec != cache_codec_none) {
+            return false;
+        }
+        bool ok = std::get<0>(read_section(c_path, c_section, &c, 1, false))
+                  and std::get<0>(read_section(t_path, t_section, &distance_m3, n_thread, false));
+        sha256 c_hash{};
+        c_hash.update(&c, sizeof(c));
+        sha256 t_hash{};
+        t_hash.update(&distance_m3, sizeof(distance_m3));
+        return ok and c_hash.digest() == c_section.sha256 and t_hash.digest() == t_section.sha256
+               and c.n_state == _size;
+    }
+
+    //  external bfs, for a table larger than the memory given to it
+    //
+    //  the table is split into partitions, each a file in "cache/<name>.bfs/", and a depth is three passes
+    //  expand     the frontier of each partition is read in chunks, the neighbors go to the bucket of their partition
+    //  update     each partition is loaded in turn and its bucket applied, a state set for the first time joins the
+    //             next frontier, and its alternatives in other partitions go to their alt bucket
+    //  alt        each partition is loaded again for its alt bucket
+    //
+    //  records are offsets in a partition, u32, the top bit of an alt record marks the smallest state of its set,
+    //  so count_distinct counts the sets as the bfs in memory does
+    //  buckets are written as sorted runs without duplicates, only one partition and a chunk of records are resident
+
+    constexpr u64 _bfs_min_flag = u64(1) << 31;
+
+    struct _bfs_partition {
+        u64 n;
+        std::unique_ptr<std::atomic_uint64_t[]> a;
+
+        explicit _bfs_partition(u64 _n) : n(_n), a(new std::atomic_uint64_t[(_n + 31) / 32]) {
+        }
+
+        u64 size_byte() const {
+            return (n + 31) / 32 * sizeof(u64);
+        }
+
+        bool compare_and_set(u64 i, u64 old_x, u64 new_x) {
+            u64 j = i / 32;
+            u64 k = i % 32 * 2;
+            u64 old_y = a[j];
+            while (((old_y >> k) & u64(3)) == old_x) {
+                u64 new_y = (old_y & ~(u64(3) << k)) | (new_x << k);
+                if (a[j].compare_exchange_strong(old_y, new_y)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void load(const std::string &path) {
+            std::ifstream f(path, std::ios::binary);
+            f.read(reinterpret_cast<char *>(a.get()), std::streamsize(size_byte()));
+            if (u64(f.gcount()) != size_byte()) {
+                throw std::runtime_error("bfs: read " + path);
+            }
+        }
+
+        void save(const std::string &path) const {
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            f.write(reinterpret_cast<const char *>(a.get()), std::streamsize(size_byte()));
+            f.close();
+            if (not f) {
+                throw std::runtime_error("bfs: write " + path);
+            }
+        }
+    };
+
+    struct _bfs_stream {
+        std::string path;
+        std::ofstream f;
+        std::mutex m;
+        u64 n = 0;
+
+        void open(const std::string &_path) {
+            path = _path;
+            f.open(path, std::ios::binary | std::ios::trunc);
+            n = 0;
+        }
+
+        //  sorted and without duplicates, one run
+        void append(std::vector<u32> &buf) {
+            if (buf.empty()) {
+                return;
+            }
+            std::sort(buf.begin(), buf.end());
+            buf.erase(std::unique(buf.begin(), buf.end()), buf.end());
+            std::lock_guard<std::mutex> lock(m);
+            f.write(reinterpret_cast<const char *>(buf.data()), std::streamsize(buf.size() * sizeof(u32)));
+            n += buf.size();
+            buf.clear();
+        }
+
+        void close() {
+            f.close();
+            if (not f) {
+                throw std::runtime_error("bfs: write " + path);
             }
         }
-        return {count_distinct, count};
+    };
+
+    //  f is called on n_thread threads for each chunk of the records
+    inline void _bfs_scan(const std::string &path, u64 n_chunk, u64 n_thread,
+                          const std::function<void(const u32 *, u64, u64)> &f) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<u32> buf(n_chunk);
+        while (in) {
+            in.read(reinterpret_cast<char *>(buf.data()), std::streamsize(n_chunk * sizeof(u32)));
+            u64 n = u64(in.gcount()) / sizeof(u32);
+            if (n == 0) {
+                break;
+            }
+            parallel_for(n, n_thread, [&](u64 start, u64 end) -> void {
+                f(buf.data(), start, end);
+            });
+        }
     }
 
     template<typename _solver>
-    std::tuple<u64, u64> _backward(const _solver &s, array_u2<_solver::n_state> &distance_m3,
-                                   u64 start, u64 end, u64 prev_depth_m3, u64 depth_m3) {
-        constexpr u64 mask = 0x5555555555555555;
-        u64 count_distinct = 0;
-        u64 count = 0;
-        for (u64 i = start; i < end; i += 32) {
-            u64 x = distance_m3.a[i / 32];
-            if (((x >> u64(1)) & x & mask) == 0) {
-                continue;
-            }
-            u64 j_end = std::min(i + 32, end);
-            for (u64 j = i; j < j_end; j++) {
-                if (distance_m3.get(j) == 3) {
-                    typename _solver::t_state a = s.int_to_state(j);
-                    for (typename _solver::t_state b: s.adj(a)) {
-                        u64 k = s.state_to_int(b);
-                        if (distance_m3.get(k) == prev_depth_m3) {
-                            u64 c = _set_multi<_solver::n_state>(distance_m3, s.alt(a, j), 3, depth_m3);
-                            if (c > 0) {
-                                count_distinct++;
-                                count += c;
+    void _bfs_external(const _solver &s, array_u2<_solver::n_state> &distance_m3, u64 n_thread,
+                       const std::string &name, u64 memory, bfs_telemetry &telemetry) {
+        constexpr u64 n_state = _solver::n_state;
+        auto t0 = std::chrono::steady_clock::now();
+
+        //  half of the memory for a partition at 4 states a byte, the rest for the chunks and their output
+        u64 part_size = std::min(std::max(memory * 2, u64(1) << 16), _bfs_min_flag) / 32 * 32;
+        u64 n_part = (n_state + part_size - 1) / part_size;
+        u64 n_chunk = std::max(memory / 4 / (sizeof(u32) * (_solver::n_base + 1)), u64(1) << 12);
+        std::string dir = "cache/" + name + ".bfs/";
+        auto path = [&dir](const std::string &kind, u64 q) -> std::string {
+            return dir + kind + "." + std::to_string(q);
+        };
+        auto part_n = [part_size](u64 q) -> u64 {
+            return std::min(part_size, n_state - q * part_size);
+        };
+        std::cout << "bfs: external " << name << ", n_partition=" << n_part << ", partition_size=" << part_size
+                  << ", memory=" << memory << std::endl;
+        telemetry.write("start", _json_fields{}("n_state", n_state)("n_thread", n_thread)("strategy", "external")
+                ("n_partition", n_part)("partition_size", part_size)("memory", memory));
+
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        for (u64 q = 0; q < n_part; q++) {
+            _bfs_partition part(part_n(q));
+            for (u64 i = 0; i < (part.n + 31) / 32; i++) {
+                part.a[i] = u64(-1);
+            }
+            part.save(path("part", q));
+            std::ofstream(path("frontier", q), std::ios::binary | std::ios::trunc);
+        }
+
+        std::vector<_bfs_stream> bucket(n_part);
+        std::vector<_bfs_stream> alt(n_part);
+        std::vector<_bfs_stream> next(n_part);
+
+        //  update and alt passes, the start states are an alt bucket of depth 0
+        auto update = [&](u64 depth_m3, bool from_alt) -> std::tuple<u64, u64> {
+            std::atomic<u64> count_distinct = 0;
+            std::atomic<u64> count = 0;
+            for (u64 q = 0; q < n_part; q++) {
+                _bfs_stream &in = from_alt ? alt[q] : bucket[q];
+                if (in.n == 0) {
+                    continue;
+                }
+                _bfs_partition part(part_n(q));
+                part.load(path("part", q));
+                _bfs_scan(in.path, n_chunk, n_thread, [&](const u32 *r, u64 start, u64 end) -> void {
+                    std::vector<std::vector<u32>> out(n_part);
+                    std::vector<u32> out_next{};
+                    u64 cd = 0;
+                    u64 c = 0;
+                    for (u64 x = start; x < end; x++) {
+                        u64 k = r[x] & (_bfs_min_flag - 1);
+                        if (not part.compare_and_set(k, 3, depth_m3)) {
+                            continue;
+                        }
+                        out_next.push_back(u32(k));
+                        c++;
+                        if (from_alt) {
+                            cd += (r[x] & _bfs_min_flag) != 0;
+                            continue;
+                        }
+                        u64 i = q * part_size + k;
+                        auto i_s = s.alt(s.int_to_state(i), i);
+                        u64 i_min = *std::min_element(i_s.begin(), i_s.end());
+                        cd += i == i_min;
+                        for (u64 j: i_s) {
+                            if (j == i) {
+                                continue;
+                            }
+                            if (j / part_size != q) {
+                                out[j / part_size].push_back(u32(j % part_size | (j == i_min ? _bfs_min_flag : 0)));
+                            } else if (part.compare_and_set(j % part_size, 3, depth_m3)) {
+                                out_next.push_back(u32(j % part_size));
+                                c++;
+                                cd += j == i_min;
                             }
                         }
                     }
+                    for (u64 p = 0; p < n_part; p++) {
+                        alt[p].append(out[p]);
+                    }
+                    next[q].append(out_next);
+                    count_distinct += cd;
+                    count += c;
+                });
+                part.save(path("part", q));
+            }
+            return {count_distinct, count};
+        };
+
+        for (u64 q = 0; q < n_part; q++) {
+            alt[q].open(path("alt", q));
+            next[q].open(path("next", q));
+        }
+        typename _solver::t_state a_start = s.cube_to_state(_solver::t_cube::i());
+        u64 i_start = s.state_to_int(a_start);
+        auto i_s_start = s.alt(a_start, i_start);
+        u64 i_min_start = *std::min_element(i_s_start.begin(), i_s_start.end());
+        for (u64 j: i_s_start) {
+            std::vector<u32> r{u32(j % part_size | (j == i_min_start ? _bfs_min_flag : 0))};
+            alt[j / part_size].append(r);
+        }
+        for (u64 q = 0; q < n_part; q++) {
+            alt[q].close();
+        }
+        auto[count_distinct_start, count_start] = update(0, true);
+        std::cout << "bfs: depth=" << 0 << ", count_distinct=" << count_distinct_start << ", count=" << count_start
+                  << std::endl;
+        u64 total_count_distinct = count_distinct_start;
+        u64 total_count = count_start;
+
+        for (u64 depth = 1; total_count != n_state; depth++) {
+            auto t1 = std::chrono::steady_clock::now();
+            for (u64 q = 0; q < n_part; q++) {
+                next[q].close();
+                std::filesystem::rename(path("next", q), path("frontier", q));
+                bucket[q].open(path("bucket", q));
+            }
+            for (u64 p = 0; p < n_part; p++) {
+                _bfs_scan(path("frontier", p), n_chunk, n_thread, [&](const u32 *r, u64 start, u64 end) -> void {
+                    std::vector<std::vector<u32>> out(n_part);
+                    for (u64 x = start; x < end; x++) {
+                        typename _solver::t_state a = s.int_to_state(p * part_size + r[x]);
+                        for (typename _solver::t_state b: s.adj(a)) {
+                            u64 k = s.state_to_int(b);
+                            out[k / part_size].push_back(u32(k % part_size));
+                        }
+                    }
+                    for (u64 q = 0; q < n_part; q++) {
+                        bucket[q].append(out[q]);
+                    }
+                });
+            }
+            for (u64 q = 0; q < n_part; q++) {
+                bucket[q].close();
+                alt[q].open(path("alt", q));
+                next[q].open(path("next", q));
+            }
+            auto[count_distinct, count] = update(depth % 3, false);
+            for (u64 q = 0; q < n_part; q++) {
+                alt[q].close();
+            }
+            auto[count_distinct_alt, count_alt] = update(depth % 3, true);
+            count_distinct += count_distinct_alt;
+            count += count_alt;
+            if (count == 0) {
+                throw std::runtime_error("bfs: " + name + " stopped at depth " + std::to_string(depth));
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            std::chrono::duration<double> d = t2 - t1;
+            std::cout << "bfs: depth=" << depth << ", count_distinct=" << count_distinct << ", count=" << count
+                      << ", time=" << d.count() << "s" << std::endl;
+            telemetry.write_depth(depth, "forward", count_distinct, count, total_count + count, d.count(), {});
+            total_count_distinct += count_distinct;
+            total_count += count;
+        }
+        for (u64 q = 0; q < n_part; q++) {
+            next[q].close();
+        }
+
+        //  in cache_data the partitions go to the cache file one by one and distance_m3 is never touched
+        if (cache_streamable(name)) {
+            cache_stream_save<array_u2<n_state>>(name, n_part, [&](u64 q, std::vector<u8> &buf) -> void {
+                buf.resize((part_n(q) + 31) / 32 * sizeof(u64));
+                std::ifstream f(path("part", q), std::ios::binary);
+                f.read(reinterpret_cast<char *>(buf.data()), std::streamsize(buf.size()));
+                if (u64(f.gcount()) != buf.size()) {
+                    throw std::runtime_error("bfs: read " + path("part", q));
                 }
+            });
+        } else {
+            for (u64 q = 0; q < n_part; q++) {
+                _bfs_partition part(part_n(q));
+                part.load(path("part", q));
+                std::memcpy(static_cast<void *>(&distance_m3.a[q * part_size / 32]), part.a.get(), part.size_byte());
             }
         }
-        return {count_distinct, count};
+        std::filesystem::remove_all(dir);
+        auto t3 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = t3 - t0;
+        std::cout << "bfs: total_count_distinct=" << total_count_distinct << ", total_count=" << total_count
+                  << ", total_time=" << d.count() << "s" << std::endl;
+        telemetry.write("end", _json_fields{}("total_count_distinct", total_count_distinct)
+                ("total_count", total_count)("total_time", d.count()));
     }
 
+    //  with a name, the progress is saved to a checkpoint after a depth once cache_options.checkpoint seconds
+    //  passed since the last one, and a build restarted later resumes from it,
+    //  a table larger than cache_options.bfs_memory is built on disk instead, without checkpoints,
+    //  and in cache_data written from disk to its cache file without filling distance_m3,
+    //  on_depth(depth) is called once a depth is done, only for a bfs without a name, which runs every depth
     template<typename _solver>
-    void bfs(const _solver &s, array_u2<_solver::n_state> &distance_m3, u64 n_thread = 1) {
+    void bfs(const _solver &s, array_u2<_solver::n_state> &distance_m3, u64 n_thread = 1,
+             const std::string &name = "", const std::function<void(u64)> &on_depth = nullptr) {
         auto t0 = std::chrono::steady_clock::now();
-        std::vector<u64> sp = _split(_solver::n_state, n_thread);
-        distance_m3.fill(3);
-        u64 count_start;
-        {
+        bool checkpoint = not name.empty() and cache_options.checkpoint > 0;
+        bfs_checkpoint progress{};
+        bfs_telemetry telemetry(name);
+        std::cout << "bfs: n_state=" << _solver::n_state << ", n_thread=" << n_thread << std::endl;
+        if (not name.empty() and cache_options.bfs_memory > 0 and cache_options.bfs_memory < sizeof(distance_m3)) {
+            _bfs_external<_solver>(s, distance_m3, n_thread, name, cache_options.bfs_memory, telemetry);
+            return;
+        }
+        if (checkpoint and _bfs_load<_solver::n_state>(name, progress, distance_m3, n_thread)) {
+            std::cout << "bfs: resume " << name << ", depth=" << progress.depth << ", total_count=" << progress.total_count
+                      << std::endl;
+        } else {
+            progress = bfs_checkpoint{_solver::n_state, 0, 1, 0, {0, 0, 0}};
+            distance_m3.fill(3);
             typename _solver::t_state a_start = s.cube_to_state(_solver::t_cube::i());
             u64 i_start = s.state_to_int(a_start);
-            count_start = _set_multi<_solver::n_state>(distance_m3, s.alt(a_start, i_start), 3, 0);
+            u64 count_start = std::get<0>(_set_multi<_solver::n_state>(distance_m3, s.alt(a_start, i_start), 3, 0));
             assert(count_start > 0);
+            std::cout << "bfs: depth=" << 0 << ", count_distinct=" << 1 << ", count=" << count_start << std::endl;
+            progress.total_count = count_start;
+            progress.count_m3[0] = count_start;
+            if (on_depth) {
+                on_depth(0);
+            }
         }
-        std::cout << "bfs: n_state=" << _solver::n_state << ", n_thread=" << n_thread << std::endl;
-        std::cout << "bfs: depth=" << 0 << ", count_distinct=" << 1 << ", count=" << count_start << std::endl;
-        u64 total_count_distinct = 1;
-        u64 total_count = count_start;
-        std::array<u64, 3> count_m3{count_start, 0, 0};
-        for (u64 depth = 1; total_count != _solver::n_state; depth++) {
+        auto last_checkpoint = std::chrono::steady_clock::now();
+        //  one pool for the whole build, its threads claim chunks of states in order at each depth,
+        //  so a dense range does not keep the others waiting, busy is the time each thread worked at a depth
+        constexpr u64 chunk_size = u64(1) << 16;
+        constexpr u64 n_chunk = (_solver::n_state + chunk_size - 1) / chunk_size;
+        worker_pool pool(n_thread);
+        bool partition = cache_options.bfs_strategy == "partition";
+        std::cout << "bfs: strategy=" << (partition ? "partition" : "cas") << ", scan=" << u2_scanner.isa << std::endl;
+        telemetry.write("start", _json_fields{}("n_state", _solver::n_state)("n_thread", n_thread)
+                ("strategy", partition ? "partition" : "cas")("scan", u2_scanner.isa)("depth", progress.depth)
+                ("total_count", progress.total_count));
+        bfs_cost_model model{};
+        u64 &total_count_distinct = progress.total_count_distinct;
+        u64 &total_count = progress.total_count;
+        std::array<u64, 3> &count_m3 = progress.count_m3;
+        for (u64 depth = progress.depth + 1; total_count != _solver::n_state; depth++) {
             auto t1 = std::chrono::steady_clock::now();
             u64 count_distinct = 0;
             u64 count = 0;
-            std::vector<std::future<std::tuple<u64, u64>>> result{};
-            if (count_m3[(depth - 1) % 3] <= _solver::n_state - total_count) {
-                for (u64 i = 0; i < n_thread; i++) {
-                    result.push_back(std::async(
-                            std::launch::async,
-                            &_forward<_solver>,
-                            std::cref(s), std::ref(distance_m3), sp[i], sp[i + 1], (depth - 1) % 3, depth % 3));
+            u64 frontier = count_m3[(depth - 1) % 3];
+            u64 unset = _solver::n_state - total_count;
+            if (cache_options.bfs_sample and not model.sampled and model.backward == 0.0
+                and unset < frontier * _bfs_sample_ratio) {
+                auto[f, b] = _bfs_sample<_solver>(
+                        s, distance_m3, pool, (depth - 1) % 3, chunk_size, _bfs_sample_stride);
+                model.forward = f;
+                model.backward = b;
+                model.sampled = true;
+                std::cout << "bfs: sample depth=" << depth << ", forward=" << f << "s, backward=" << b << "s"
+                          << std::endl;
+            }
+            auto[cost_forward, cost_backward] = model.estimate(frontier, unset);
+            bool backward = cost_backward < cost_forward;
+            const char *direction = backward ? "backward" : "forward";
+            telemetry.write("decision", _json_fields{}("depth", depth)("frontier", frontier)("unset", unset)
+                    ("cost_forward", cost_forward)("cost_backward", cost_backward)("sampled", model.sampled)
+                    ("direction", direction));
+            std::vector<bfs_thread_stat> stats(n_thread);
+            //  called by one thread at a time, the first of the pool or the one running the rounds
+            auto last_progress = t1;
+            auto report = [&](double done) -> void {
+                auto now = std::chrono::steady_clock::now();
+                std::chrono::duration<double> since = now - last_progress;
+                if (cache_options.bfs_progress == 0 or since.count() < double(cache_options.bfs_progress)
+                    or done <= 0.0) {
+                    return;
                 }
+                last_progress = now;
+                std::chrono::duration<double> elapsed = now - t1;
+                double eta = elapsed.count() * (1.0 - done) / done;
+                std::cout << "bfs: progress depth=" << depth << ", direction=" << direction << ", done=" << done
+                          << ", elapsed=" << elapsed.count() << "s, eta=" << eta << "s" << std::endl;
+                telemetry.write("progress", _json_fields{}("depth", depth)("direction", direction)("done", done)
+                        ("elapsed", elapsed.count())("eta", eta));
+            };
+            if (partition) {
+                _bfs_partitioned<_solver>(s, distance_m3, pool, (depth - 1) % 3, depth % 3, backward, stats, report);
             } else {
-                for (u64 i = 0; i < n_thread; i++) {
-                    result.push_back(std::async(
-                            std::launch::async,
-                            &_backward<_solver>,
-                            std::cref(s), std::ref(distance_m3), sp[i], sp[i + 1], (depth - 1) % 3, depth % 3));
-                }
+                std::atomic<u64> next_chunk{0};
+                pool.run([&](u64 t) -> void {
+                    auto b0 = std::chrono::steady_clock::now();
+                    bfs_thread_stat &x = stats[t];
+                    auto visit = [&](const typename _solver::t_state &a, u64 i) -> void {
+                        auto[c_i, is_min] = _set_multi<_solver::n_state>(distance_m3, s.alt(a, i), 3, depth % 3);
+                        if (c_i > 0) {
+                            x.count_distinct += is_min;
+                            x.count += c_i;
+                        } else {
+                            x.cas_fail++;
+                        }
+                    };
+                    for (u64 k = next_chunk++; k < n_chunk; k = next_chunk++) {
+                        u64 start = k * chunk_size;
+                        u64 end = std::min(start + chunk_size, _solver::n_state);
+                        if (backward) {
+                            x.scanned += _backward<_solver>(s, distance_m3, start, end, (depth - 1) % 3, visit);
+                        } else {
+                            x.scanned += _forward<_solver>(s, distance_m3, start, end, (depth - 1) % 3, visit);
+                        }
+                        if (t == 0) {
+                            report(double(std::min(u64(next_chunk), n_chunk)) / double(n_chunk));
+                        }
+                    }
+                    auto b1 = std::chrono::steady_clock::now();
+                    std::chrono::duration<double> b = b1 - b0;
+                    x.time = b.count();
+                });
             }
+            model.update(backward, stats);
+            std::vector<double> busy(n_thread);
             for (u64 i = 0; i < n_thread; i++) {
-                auto[cd, c] = result[i].get();
-                count_distinct += cd;
-                count += c;
+                count_distinct += stats[i].count_distinct;
+                count += stats[i].count;
+                busy[i] = stats[i].time;
             }
             auto t2 = std::chrono::steady_clock::now();
             std::chrono::duration<double> d = t2 - t1;
             std::cout << "bfs: depth=" << depth << ", count_distinct=" << count_distinct << ", count=" << count
-                      << ", time=" << d.count() << "s" << std::endl;
+                      << ", time=" << d.count() << "s, direction=" << direction << ", busy=" << vector_to_string(busy)
+                      << std::endl;
+            telemetry.write_depth(depth, direction, count_distinct, count, total_count + count, d.count(), stats);
             total_count_distinct += count_distinct;
             total_count += count;
             count_m3[depth % 3] += count;
+            if (on_depth) {
+                on_depth(depth);
+            }
+            progress.depth = depth;
+            std::chrono::duration<double> since = t2 - last_checkpoint;
+            if (checkpoint and total_count != _solver::n_state
+                and since.count() >= double(cache_options.checkpoint)) {
+                _bfs_save<_solver::n_state>(name, progress, distance_m3, n_thread);
+                telemetry.write("checkpoint", _json_fields{}("depth", depth));
+                last_checkpoint = std::chrono::steady_clock::now();
+            }
+        }
+        //  in cache_data the checkpoint is kept until the table is saved
+        if (checkpoint and cache_computing.name != name) {
+            std::filesystem::remove("cache/" + name + ".checkpoint");
         }
         auto t3 = std::chrono::steady_clock::now();
         std::chrono::duration<double> d = t3 - t0;
         std::cout << "bfs: total_count_distinct=" << total_count_distinct << ", total_count=" << total_count
                   << ", total_time=" << d.count() << "s" << std::endl;
+        telemetry.write("end", _json_fields{}("total_count_distinct", total_count_distinct)
+                ("total_count", total_count)("total_time", d.count()));
     }
 
     constexpr u64 computer_distance(u64 distance_m3, u64 distance_adj) {
@@ -420,6 +1441,89 @@ namespace cube {
         }
     };
 
+    //  the exact distances of the states of a solver, by its bfs run again into a temporary array_u2,
+    //  after each depth the states of the depth modulo 3 still unset in distance_u4 are those reached at the depth,
+    //  so one pass over both tables a depth fills distance_u4
+    template<typename _solver>
+    void bfs_exact(const _solver &s, array_u4<_solver::n_state> &distance_u4, u64 n_thread = 1) {
+        constexpr u64 n_word = (_solver::n_state + 15) / 16;
+        std::unique_ptr<array_u2<_solver::n_state>> distance_m3(new array_u2<_solver::n_state>);
+        distance_u4.fill(array_u4<_solver::n_state>::unset);
+        bfs<_solver>(s, *distance_m3, n_thread, "", [&](u64 depth) -> void {
+            if (depth >= array_u4<_solver::n_state>::unset) {
+                throw std::runtime_error("bfs_exact: depth " + std::to_string(depth) + " does not fit in 4 bits");
+            }
+            parallel_for(n_word, n_thread, [&](u64 start, u64 end) -> void {
+                for (u64 w = start; w < end; w++) {
+                    u64 m = _match_u2(distance_m3->a[w / 2].load(std::memory_order_relaxed), depth % 3) >> (w % 2 * 32) & 0xffffffff;
+                    u64 y = distance_u4.a[w];
+                    for (; m != 0; m &= m - 1) {
+                        u64 k = u64(__builtin_ctzll(m)) * 2;
+                        if (((y >> k) & u64(15)) == array_u4<_solver::n_state>::unset) {
+                            y = (y & ~(u64(15) << k)) | (depth << k);
+                        }
+                    }
+                    distance_u4.a[w] = y;
+                }
+            });
+        });
+    }
+
+    //  _solver with the distances in an array_u4 named name instead of modulo 3 in its array_u2,
+    //  get_distance is one lookup and the nodes of ida_star carry no hint, for twice the memory of the array_u2,
+    //  which is only in memory while distance_u4 is built, the distances must be at most 14
+    template<typename _solver, const char *name>
+    struct exact_solver : _solver {
+        struct t_hint {
+        };
+
+        cache_ptr<array_u4<_solver::n_state>> distance_u4;
+
+        //  the array_u2 of bfs_exact is in memory while distance_u4 is built
+        static constexpr u64 table_memory() {
+            return _solver::table_memory() + sizeof(array_u4<_solver::n_state>);
+        }
+
+        //  bfs_exact runs a bfs of its own, so the array_u2 of _solver is neither loaded nor built
+        explicit exact_solver(u64 _n_thread) : exact_solver(_n_thread, cache_skip<array_u2<_solver::n_state>>()) {
+        }
+
+        exact_solver(u64 _n_thread, const cache_skip<array_u2<_solver::n_state>> &) : _solver(_n_thread) {
+            distance_u4 = cache_data<array_u4<_solver::n_state>>(
+                    name,
+                    [this](array_u4<_solver::n_state> &t) -> void {
+                        bfs_exact<_solver>(*this, t, this->n_thread);
+                    }
+            );
+        }
+
+        template<u64 capacity>
+        ida_star <exact_solver, capacity> solve(const typename _solver::t_cube &a, u64 max_n_moves = capacity) const {
+            return ida_star<exact_solver, capacity>(*this, a, max_n_moves);
+        }
+    };
+
+    template<typename _solver, const char *name>
+    struct get_distance<exact_solver<_solver, name>> {
+        typedef exact_solver<_solver, name> _exact_solver;
+
+        static std::tuple<u64, typename _exact_solver::t_hint> call(
+                const _exact_solver &s, const typename _solver::t_state &a) {
+            return {s.distance_u4->get(s.state_to_int(a)), {}};
+        }
+    };
+
+    template<typename _solver, const char *name>
+    struct get_distance_hint<exact_solver<_solver, name>> {
+        typedef exact_solver<_solver, name> _exact_solver;
+
+        static std::tuple<u64, typename _exact_solver::t_hint> call(
+                const _exact_solver &s, const typename _solver::t_state &a,
+                const typename _exact_solver::t_hint &) {
+            return {s.distance_u4->get(s.state_to_int(a)), {}};
+        }
+    };
+
     template<typename _solver0, typename _solver1, u64 capacity>
     struct combine_search {
         typedef decltype(_solver0(1).template solve<capacity>(_solver0::t_cube::i())) t_iter0;
@@ -544,7 +1648,19 @@ namespace cube {
         _solver0 s0;
         _solver1 s1;
 
-        explicit combine_solver(u64 _n_thread) : n_thread(_n_thread), s0(_n_thread), s1(_n_thread) {
+        static constexpr u64 table_memory() {
+            return _solver0::table_memory() + _solver1::table_memory();
+        }
+
+        //  both solvers are built at the same time
+        explicit combine_solver(u64 _n_thread) : combine_solver(
+                _n_thread,
+                std::async(std::launch::async, [_n_thread]() -> _solver0 { return _solver0(_n_thread); }),
+                std::async(std::launch::async, [_n_thread]() -> _solver1 { return _solver1(_n_thread); })) {
+        }
+
+        combine_solver(u64 _n_thread, std::future<_solver0> f0, std::future<_solver1> f1) :
+                n_thread(_n_thread), s0(f0.get()), s1(f1.get()) {
         }
 
         template<u64 capacity>
@@ -553,6 +1669,65 @@ namespace cube {
         }
     };
 
+    //  a copy of a solver whose tables read most by the search are replicated on a numa node,
+    //  solvers without a specialization share all their tables
+    template<typename _solver>
+    struct numa_replica {
+        static _solver call(const _solver &s, u64 node) {
+            return s;
+        }
+    };
+
+    template<typename _solver, const char *name>
+    struct numa_replica<exact_solver<_solver, name>> {
+        static exact_solver<_solver, name> call(const exact_solver<_solver, name> &s, u64 node) {
+            exact_solver<_solver, name> r = s;
+            r.distance_u4 = cache_replicate(name, s.distance_u4, node);
+            return r;
+        }
+    };
+
+    //  the replicas of a solver on each numa node with cache_options.numa "replicate", made by the constructor
+    //  and freed by the destructor, so it must not outlive the solver, get finds them while they live
+    template<typename _solver>
+    struct numa_solvers {
+        typedef std::vector<_solver> t_replicas;
+
+        const _solver &s;
+
+        explicit numa_solvers(const _solver &_s) : s(_s) {
+            u64 n_node = numa_nodes().size();
+            if (cache_options.numa == "replicate" and n_node > 1) {
+                auto r = std::make_shared<t_replicas>();
+                for (u64 node = 0; node < n_node; node++) {
+                    r->push_back(numa_replica<_solver>::call(s, node));
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                replicas[&s] = r;
+            }
+        }
+
+        numa_solvers(const numa_solvers &) = delete;
+
+        numa_solvers &operator=(const numa_solvers &) = delete;
+
+        ~numa_solvers() {
+            std::lock_guard<std::mutex> lock(mutex);
+            replicas.erase(&s);
+        }
+
+        //  the replicas of s, nullptr when there are none
+        static std::shared_ptr<const t_replicas> get(const _solver &s) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = replicas.find(&s);
+            return it == replicas.end() ? nullptr : it->second;
+        }
+
+    private:
+        static inline std::mutex mutex{};
+        static inline std::map<const _solver *, std::shared_ptr<const t_replicas>> replicas{};
+    };
+
     template<typename _solver, u64 capacity>
     struct thread_dfs {
         static constexpr char name[] = "thread";
@@ -620,14 +1795,19 @@ namespace cube {
                 const _solver &s, const std::vector<node> &nodes, u64 n_thread, u64 n_moves,
                 const std::vector<u64> &tasks, const std::vector<u64> &split, std::vector<u64> &count,
                 std::vector<std::tuple<u64, t_moves<capacity>>> &result, volatile bool &stop) {
+            //  with replicas, the threads are split into contiguous groups, one per node, pinned to it
+            std::shared_ptr<const std::vector<_solver>> replicas = numa_solvers<_solver>::get(s);
             std::vector<std::future<void>> future{};
             for (u64 i = 0; i < n_thread; i++) {
-                future.push_back(std::async(
-                        std::launch::async,
-                        &thread_dfs<_solver, capacity>::dfs_multi,
-                        std::cref(s), std::cref(nodes), n_moves,
-                        std::cref(tasks), std::cref(split), std::ref(count),
-                        std::ref(result[i]), std::ref(stop), i));
+                future.push_back(std::async(std::launch::async, [&, i]() -> void {
+                    const _solver *s_i = &s;
+                    if (replicas != nullptr) {
+                        u64 node = i * replicas->size() / n_thread;
+                        numa_pin(node);
+                        s_i = &(*replicas)[node];
+                    }
+                    dfs_multi(*s_i, nodes, n_moves, tasks, split, count, result[i], stop, i);
+                }));
             }
             for (u64 i = 0; i < n_thread; i++) {
                 future[i].get();
@@ -917,6 +2097,7 @@ namespace cube {
                     std::cout << "parallel_ida_star: found, n_moves=" << n_moves
                               << ", count=" << vector_sum<u64>(count)
                               << ", efficiency=" << _efficiency(n_thread, 0, tasks, split, count)
+                              << ", speed=" << double(vector_sum<u64>(count)) / d21.count() << "node/s"
                               << ", layer_time=" << d21.count()
                               << "s, total_time=" << d20.count() << "s" << std::endl;
                     return {f, moves};
@@ -924,6 +2105,7 @@ namespace cube {
                     std::cout << "parallel_ida_star: complete, n_moves=" << n_moves
                               << ", count=" << vector_sum<u64>(count)
                               << ", efficiency=" << _efficiency(n_thread, 0, tasks, split, count)
+                              << ", speed=" << double(vector_sum<u64>(count)) / d21.count() << "node/s"
                               << ", layer_time=" << d21.count()
                               << "s, total_time=" << d20.count() << "s" << std::endl;
                 }
@@ -3,6 +3,7 @@
 #include "base.h"
 #include "group.h"
 #include "search.h"
+#include "cache.h"
 #include "cube3.h"
 #include "cube3_2p.h"
 #include "cube3_opt.h"
@@ -97,12 +98,16 @@ struct g_thread_opt_solver_d : solver_d {
     u64 n_pd_thread;
     u64 bfs_count;
 
+    //  the numa replicas of the solver, freed with this, before the solver
+    std::unique_ptr<numa_solvers<_opt_solver>> numa;
+
     g_thread_opt_solver_d(const std::string &_schedule, u64 n_thread, u64 _bfs_count) :
             pd_opt_s(nullptr), schedule(_schedule), n_pd_thread(n_thread), bfs_count(_bfs_count) {
         if (opt_s<_opt_solver> == nullptr) {
             opt_s<_opt_solver> = std::make_unique<_opt_solver>(n_thread);
         }
         pd_opt_s = opt_s<_opt_solver>.get();
+        numa = std::make_unique<numa_solvers<_opt_solver>>(*pd_opt_s);
     }
 
     ~g_thread_opt_solver_d() override = default;
@@ -235,10 +240,16 @@ void parse_arg(
         int argc, char **argv,
         std::string &algorithm, std::string &schedule, u64 &n_thread, u64 &n_cuda_thread,
         u64 &_2p_n_moves, u64 &sym_n_moves, u64 &n_solution, u64 &bfs_count,
-        std::string &input, std::string &output) {
+        bool &cache_mmap, bool &cache_direct, bool &cache_shm, bool &cache_compress, std::string &cache_verify,
+        std::string &huge_page, std::string &warmup, std::string &numa, u64 &bfs_checkpoint, u64 &bfs_memory,
+        u64 &memory, std::string &input, std::string &output) {
     std::set<std::string> algorithm_set = {
-            "2p", "optx", "thread_optx", "cuda_optx", "opty", "thread_opty", "cuda_opty"};
+            "auto", "2p", "optx", "thread_optx", "cuda_optx", "opty", "thread_opty", "cuda_opty"};
     std::set<std::string> schedule_set = {"simple", "linear", "best"};
+    std::set<std::string> cache_verify_set = {"none", "rebuild", "refuse"};
+    std::set<std::string> huge_page_set = {"none", "thp", "2m", "1g"};
+    std::set<std::string> warmup_set = {"none", "prefault", "mlock"};
+    std::set<std::string> numa_set = {"none", "interleave", "replicate"};
     std::tuple<u64, u64> n_thread_t = {1, 256};
     std::tuple<u64, u64> n_cuda_thread_t = {1, 65536};
     std::tuple<u64, u64> _2p_n_moves_t = {0, 29};
@@ -248,7 +259,7 @@ void parse_arg(
 
     cxxopts::Options option(argv[0], "Rubik's Cube Solver (Parallel)");
     option.add_options()
-            ("algorithm", "(2p | optx | thread_optx | cuda_optx | opty | thread_opty | cuda_opty)",
+            ("algorithm", "(auto | 2p | optx | thread_optx | cuda_optx | opty | thread_opty | cuda_opty)",
              cxxopts::value<std::string>(algorithm))
             ("schedule", "(simple | linear | best)", cxxopts::value<std::string>(schedule)->default_value("simple"))
             ("n_thread", "1~256", cxxopts::value<u64>(n_thread)->default_value("4"))
@@ -257,6 +268,18 @@ void parse_arg(
             ("sym_n_moves", "0~20", cxxopts::value<u64>(sym_n_moves)->default_value("6"))
             ("n_solution", "1~max", cxxopts::value<u64>(n_solution)->default_value("1"))
             ("bfs_count", "1~max", cxxopts::value<u64>(bfs_count)->default_value("100000"))
+            ("cache_mmap", "bool", cxxopts::value<bool>(cache_mmap)->default_value("false"))
+            ("cache_direct", "bool", cxxopts::value<bool>(cache_direct)->default_value("false"))
+            ("cache_shm", "bool", cxxopts::value<bool>(cache_shm)->default_value("false"))
+            ("cache_compress", "bool", cxxopts::value<bool>(cache_compress)->default_value("false"))
+            ("cache_verify", "(none | rebuild | refuse), none by default so the tables are not hashed at each start",
+             cxxopts::value<std::string>(cache_verify)->default_value("none"))
+            ("huge_page", "(none | thp | 2m | 1g)", cxxopts::value<std::string>(huge_page)->default_value("none"))
+            ("warmup", "(none | prefault | mlock)", cxxopts::value<std::string>(warmup)->default_value("none"))
+            ("numa", "(none | interleave | replicate)", cxxopts::value<std::string>(numa)->default_value("none"))
+            ("bfs_checkpoint", "0~max seconds", cxxopts::value<u64>(bfs_checkpoint)->default_value("600"))
+            ("bfs_memory", "0~max MB", cxxopts::value<u64>(bfs_memory)->default_value("0"))
+            ("memory", "0~max MB, 0 for the available memory", cxxopts::value<u64>(memory)->default_value("0"))
             ("input", "input file name", cxxopts::value<std::string>(input)->default_value(""))
             ("output", "output file name", cxxopts::value<std::string>(output)->default_value(""))
             ("help", "show help");
@@ -286,6 +309,26 @@ void parse_arg(
         exit(1);
     }
 
+    if (cache_verify_set.find(cache_verify) == cache_verify_set.end()) {
+        std::cout << "error cache_verify: " << cache_verify << std::endl;
+        exit(1);
+    }
+
+    if (huge_page_set.find(huge_page) == huge_page_set.end()) {
+        std::cout << "error huge_page: " << huge_page << std::endl;
+        exit(1);
+    }
+
+    if (warmup_set.find(warmup) == warmup_set.end()) {
+        std::cout << "error warmup: " << warmup << std::endl;
+        exit(1);
+    }
+
+    if (numa_set.find(numa) == numa_set.end()) {
+        std::cout << "error numa: " << numa << std::endl;
+        exit(1);
+    }
+
     if (n_thread < std::get<0>(n_thread_t) or n_thread > std::get<1>(n_thread_t)) {
         std::cout << "error n_thread: " << n_thread << std::endl;
         exit(1);
@@ -322,6 +365,62 @@ void parse_arg(
     }
 }
 
+//  memory of the tables of each algorithm, from the table types of its solvers
+const std::map<std::string, u64> algorithm_memory = {
+        {"2p",          _2ps_solver::table_memory()},
+        {"optx",        optx_solver::table_memory()},
+        {"thread_optx", optx_solver::table_memory()},
+        {"cuda_optx",   optx_solver::table_memory()},
+        {"opty",        opty_solver::table_memory()},
+        {"thread_opty", opty_solver::table_memory()},
+        {"cuda_opty",   opty_solver::table_memory()}
+};
+
+//  memory numa_replica copies to each node but the first with --numa replicate,
+//  conj_mul_egp_eo and distance_m3 of p0s and distance_m3 of c8
+template<typename _opt_solver>
+constexpr u64 replica_memory() {
+    typedef typename _opt_solver::p0s_solver _p0s_solver;
+    return cache_size<decltype(_p0s_solver::conj_mul_egp_eo), decltype(_p0s_solver::distance_m3),
+            decltype(c8_solver::distance_m3)>();
+}
+
+const std::map<std::string, u64> algorithm_replica_memory = {
+        {"thread_optx", replica_memory<optx_solver>()},
+        {"thread_opty", replica_memory<opty_solver>()}
+};
+
+//  checks the algorithm fits in the memory available before any table is allocated,
+//  auto takes the fastest one which fits, opty, then optx, then 2p,
+//  the tables kept by the solvers and their numa replicas are counted, not the buffers used for a while
+//  to build or save a table missing in the cache
+std::string plan_algorithm(const std::string &algorithm, u64 n_thread, u64 memory) {
+    auto[available, source] = cache_memory_available();
+    if (memory > 0) {
+        available = memory;
+        source = "option";
+    }
+    u64 n_replica = cache_options.numa == "replicate" ? std::max(numa_nodes().size(), size_t(1)) - 1 : 0;
+    auto need = [n_replica](const std::string &c) -> u64 {
+        auto it = algorithm_replica_memory.find(c);
+        return algorithm_memory.at(c) + (it == algorithm_replica_memory.end() ? 0 : n_replica * it->second);
+    };
+    std::vector<std::string> candidates{algorithm};
+    if (algorithm == "auto") {
+        candidates = {n_thread > 1 ? "thread_opty" : "opty", n_thread > 1 ? "thread_optx" : "optx", "2p"};
+    }
+    for (const std::string &c: candidates) {
+        std::cout << "memory: algorithm=" << c << ", need=" << need(c) << ", n_replica=" << n_replica
+                  << ", available=" << available << ", source=" << source << std::endl;
+        if (need(c) <= available) {
+            return c;
+        }
+    }
+    std::cout << "error memory: " << candidates.back() << " needs " << need(candidates.back())
+              << " bytes, " << available << " bytes available (" << source << ")" << std::endl;
+    exit(1);
+}
+
 int main(int argc, char **argv) {
     std::string algorithm;
     std::string schedule;
@@ -331,13 +430,39 @@ int main(int argc, char **argv) {
     u64 sym_n_moves;
     u64 n_solution;
     u64 bfs_count;
+    bool cache_mmap;
+    bool cache_direct;
+    bool cache_shm;
+    bool cache_compress;
+    std::string cache_verify;
+    std::string huge_page;
+    std::string warmup;
+    std::string numa;
+    u64 bfs_checkpoint;
+    u64 bfs_memory;
+    u64 memory;
     std::string input;
     std::string output;
 
     parse_arg(argc, argv,
               algorithm, schedule, n_thread, n_cuda_thread,
               _2p_n_moves, sym_n_moves, n_solution, bfs_count,
-              input, output);
+              cache_mmap, cache_direct, cache_shm, cache_compress, cache_verify, huge_page, warmup, numa,
+              bfs_checkpoint, bfs_memory, memory, input, output);
+
+    cache_options.mmap = cache_mmap;
+    cache_options.n_stream = n_thread;
+    cache_options.direct = cache_direct;
+    cache_options.shm = cache_shm;
+    cache_options.compress = cache_compress;
+    cache_options.verify = cache_verify;
+    cache_options.huge_page = huge_page;
+    cache_options.numa = numa;
+    if (numa != "none") {
+        std::cout << "numa: policy=" << numa << ", n_node=" << numa_nodes().size() << std::endl;
+    }
+    cache_options.checkpoint = bfs_checkpoint;
+    cache_options.bfs_memory = bfs_memory << 20;
 
     std::unique_ptr<std::ifstream> in_f = input.empty() ? nullptr :
                                           std::make_unique<std::ifstream>(input, std::ios::binary);
@@ -346,25 +471,36 @@ int main(int argc, char **argv) {
     std::istream &in = input.empty() ? std::cin : *in_f;
     std::ostream &out = output.empty() ? std::cout : *out_f;
 
+    algorithm = plan_algorithm(algorithm, n_thread, memory << 20);
+
     std::unique_ptr<solver_d> sd = nullptr;
-    if (algorithm == "2p") {
-        sd = std::make_unique<_2p_solver_d>(n_thread, _2p_n_moves);
-    } else if (algorithm == "optx") {
-        sd = std::make_unique<g_opt_solver_d<optx_solver>>(n_thread, sym_n_moves, n_solution);
-    } else if (algorithm == "thread_optx") {
-        sd = std::make_unique<g_thread_opt_solver_d<optx_solver>>(schedule, n_thread, bfs_count);
-    } else if (algorithm == "cuda_optx") {
-        sd = std::make_unique<g_cuda_opt_solver_d<optx_solver, cuda_cube::optx_solver>>(
-                schedule, n_thread, n_cuda_thread, bfs_count);
-    } else if (algorithm == "opty") {
-        sd = std::make_unique<g_opt_solver_d<opty_solver>>(n_thread, sym_n_moves, n_solution);
-    } else if (algorithm == "thread_opty") {
-        sd = std::make_unique<g_thread_opt_solver_d<opty_solver>>(schedule, n_thread, bfs_count);
-    } else if (algorithm == "cuda_opty") {
-        sd = std::make_unique<g_cuda_opt_solver_d<opty_solver, cuda_cube::opty_solver>>(
-                schedule, n_thread, n_cuda_thread, bfs_count);
-    } else {
-        assert(0);
+    try {
+        if (algorithm == "2p") {
+            sd = std::make_unique<_2p_solver_d>(n_thread, _2p_n_moves);
+        } else if (algorithm == "optx") {
+            sd = std::make_unique<g_opt_solver_d<optx_solver>>(n_thread, sym_n_moves, n_solution);
+        } else if (algorithm == "thread_optx") {
+            sd = std::make_unique<g_thread_opt_solver_d<optx_solver>>(schedule, n_thread, bfs_count);
+        } else if (algorithm == "cuda_optx") {
+            sd = std::make_unique<g_cuda_opt_solver_d<optx_solver, cuda_cube::optx_solver>>(
+                    schedule, n_thread, n_cuda_thread, bfs_count);
+        } else if (algorithm == "opty") {
+            sd = std::make_unique<g_opt_solver_d<opty_solver>>(n_thread, sym_n_moves, n_solution);
+        } else if (algorithm == "thread_opty") {
+            sd = std::make_unique<g_thread_opt_solver_d<opty_solver>>(schedule, n_thread, bfs_count);
+        } else if (algorithm == "cuda_opty") {
+            sd = std::make_unique<g_cuda_opt_solver_d<opty_solver, cuda_cube::opty_solver>>(
+                    schedule, n_thread, n_cuda_thread, bfs_count);
+        } else {
+            assert(0);
+        }
+    } catch (const std::runtime_error &e) {
+        std::cout << "error cache: " << e.what() << std::endl;
+        exit(1);
+    }
+    print_cache_timeline();
+    if (warmup != "none") {
+        cache_warmup(n_thread, warmup == "mlock");
     }
 
     cube3_interface cube3_i{};
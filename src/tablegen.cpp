@@ -0,0 +1,294 @@
+#include <sstream>
+
+#include "cxxopts.hpp"
+
+#include "base.h"
+#include "cache.h"
+#include "search.h"
+#include "cube2.h"
+#include "cube3.h"
+#include "cube3_2p.h"
+#include "cube3_opt.h"
+#include "cube3_e12.h"
+
+using namespace cube;
+using namespace cube::_2;
+using namespace cube::_3;
+using namespace cube::_3::_2p;
+using namespace cube::_3::opt;
+using namespace cube::_3::e12;
+
+//  the tables of one solver, built by constructing it,
+//  the tables inside a solver are built concurrently along their dependencies by cache_data_async
+struct target {
+    std::string name;
+    u64 memory;
+    std::function<void(u64)> build;
+};
+
+template<typename _solver>
+target make_target(const std::string &name) {
+    return target{name, _solver::table_memory(), [](u64 n_thread) -> void {
+        _solver s(n_thread);
+    }};
+}
+
+std::vector<target> all_targets() {
+    return {
+            make_target<cube2_solver>("cube2"),
+            make_target<p0_solver>("p0"),
+            make_target<p0s_solver>("p0s"),
+            make_target<p1_solver>("p1"),
+            make_target<p1s_solver>("p1s"),
+            make_target<c8_solver>("c8"),
+            make_target<p0sx_solver>("p0sx"),
+            make_target<p0sy_solver>("p0sy"),
+            make_target<e12s_solver>("e12s"),
+            make_target<cube2_exact_solver>("cube2_exact"),
+            make_target<p0s_exact_solver>("p0s_exact"),
+            make_target<c8_exact_solver>("c8_exact")
+    };
+}
+
+//  resident and peak resident bytes of this process, zero where /proc is not available
+std::tuple<u64, u64> read_rss() {
+    std::ifstream f("/proc/self/status");
+    u64 rss = 0;
+    u64 hwm = 0;
+    std::string line;
+    while (std::getline(f, line)) {
+        unsigned long kb = 0;
+        if (sscanf(line.c_str(), "VmRSS: %lu kB", &kb) == 1) {
+            rss = u64(kb) << 10;
+        } else if (sscanf(line.c_str(), "VmHWM: %lu kB", &kb) == 1) {
+            hwm = u64(kb) << 10;
+        }
+    }
+    return {rss, hwm};
+}
+
+//  starts the largest targets first, and any target whose tables fit in what is left of the memory budget,
+//  a target larger than the budget runs alone, a table shared by targets running together is computed by one of them,
+//  process_peak_rss is the largest resident size of the whole process seen while the target ran,
+//  so it includes the targets running with it
+void build(const std::vector<target> &targets, u64 n_thread, u64 memory) {
+    std::vector<u64> pending(targets.size());
+    std::iota(pending.begin(), pending.end(), 0);
+    std::stable_sort(pending.begin(), pending.end(), [&targets](u64 i, u64 j) -> bool {
+        return targets[i].memory > targets[j].memory;
+    });
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    u64 used = 0;
+    u64 n_done = 0;
+    std::set<u64> running{};
+    std::vector<u64> peak_rss(targets.size(), 0);
+    std::exception_ptr error = nullptr;
+    bool stop = false;
+
+    std::thread sampler([&]() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (not stop) {
+            lock.unlock();
+            auto[rss, hwm] = read_rss();
+            lock.lock();
+            for (u64 i: running) {
+                peak_rss[i] = std::max(peak_rss[i], rss);
+            }
+            cv.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    });
+
+    std::vector<std::future<void>> futures{};
+    std::unique_lock<std::mutex> lock(mutex);
+    while (not pending.empty() or not running.empty()) {
+        for (auto it = pending.begin(); it != pending.end() and error == nullptr;) {
+            u64 i = *it;
+            if (not running.empty() and memory > 0 and used + targets[i].memory > memory) {
+                ++it;
+                continue;
+            }
+            it = pending.erase(it);
+            used += targets[i].memory;
+            running.insert(i);
+            std::cout << "tablegen: start " << targets[i].name << ", memory=" << targets[i].memory
+                      << ", used=" << used << std::endl;
+            futures.push_back(std::async(std::launch::async, [&, i]() -> void {
+                auto t0 = std::chrono::steady_clock::now();
+                std::exception_ptr e = nullptr;
+                try {
+                    targets[i].build(n_thread);
+                } catch (...) {
+                    e = std::current_exception();
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                std::chrono::duration<double> d = t1 - t0;
+                auto[rss, hwm] = read_rss();
+                std::lock_guard<std::mutex> done_lock(mutex);
+                peak_rss[i] = std::max(peak_rss[i], rss);
+                std::cout << "tablegen: done " << targets[i].name << (e ? " failed" : " ok")
+                          << ", time=" << d.count() << "s, memory=" << targets[i].memory
+                          << ", process_peak_rss=" << peak_rss[i] << std::endl;
+                if (e != nullptr and error == nullptr) {
+                    error = e;
+                }
+                used -= targets[i].memory;
+                running.erase(i);
+                n_done++;
+                cv.notify_all();
+            }));
+        }
+        if (error != nullptr) {
+            pending.clear();
+        }
+        if (running.empty()) {
+            break;
+        }
+        u64 n = n_done;
+        cv.wait(lock, [&n, &n_done]() -> bool {
+            return n_done != n;
+        });
+    }
+    stop = true;
+    cv.notify_all();
+    lock.unlock();
+    sampler.join();
+    for (std::future<void> &f: futures) {
+        f.get();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+void parse_arg(
+        int argc, char **argv,
+        std::string &tables, u64 &n_thread, u64 &memory, u64 &bfs_memory, std::string &bfs_strategy,
+        bool &bfs_telemetry, u64 &bfs_progress, bool &bfs_sample, bool &cache_compress, std::string &cache_verify,
+        std::string &manifest) {
+    std::set<std::string> bfs_strategy_set = {"cas", "partition"};
+    std::set<std::string> cache_verify_set = {"none", "rebuild", "refuse"};
+    std::tuple<u64, u64> n_thread_t = {1, 256};
+
+    cxxopts::Options option(argv[0], "Build the cache tables of the solvers");
+    option.add_options()
+            ("tables", "all, or some of (cube2,p0,p0s,p1,p1s,c8,p0sx,p0sy,e12s,cube2_exact,p0s_exact,c8_exact)",
+             cxxopts::value<std::string>(tables)->default_value("all"))
+            ("n_thread", "1~256", cxxopts::value<u64>(n_thread)->default_value("4"))
+            ("memory", "0~max MB, 0 for no limit", cxxopts::value<u64>(memory)->default_value("0"))
+            ("bfs_memory", "0~max MB", cxxopts::value<u64>(bfs_memory)->default_value("0"))
+            ("bfs_strategy", "(cas | partition)",
+             cxxopts::value<std::string>(bfs_strategy)->default_value("cas"))
+            ("bfs_telemetry", "bool", cxxopts::value<bool>(bfs_telemetry)->default_value("false"))
+            ("bfs_progress", "0~max seconds", cxxopts::value<u64>(bfs_progress)->default_value("60"))
+            ("bfs_sample", "bool", cxxopts::value<bool>(bfs_sample)->default_value("true"))
+            ("cache_compress", "bool", cxxopts::value<bool>(cache_compress)->default_value("false"))
+            ("cache_verify", "(none | rebuild | refuse), rebuild by default so a bad table is not baked into an image",
+             cxxopts::value<std::string>(cache_verify)->default_value("rebuild"))
+            ("manifest", "write the sha256 of the tables to this file",
+             cxxopts::value<std::string>(manifest)->default_value(""))
+            ("help", "show help");
+
+    try {
+        cxxopts::ParseResult result = option.parse(argc, argv);
+        if (result.count("help") > 0) {
+            std::cout << option.help() << std::endl;
+            exit(0);
+        }
+    } catch (const cxxopts::OptionException &e) {
+        std::cout << "error option: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    if (bfs_strategy_set.find(bfs_strategy) == bfs_strategy_set.end()) {
+        std::cout << "error bfs_strategy: " << bfs_strategy << std::endl;
+        exit(1);
+    }
+
+    if (cache_verify_set.find(cache_verify) == cache_verify_set.end()) {
+        std::cout << "error cache_verify: " << cache_verify << std::endl;
+        exit(1);
+    }
+
+    if (n_thread < std::get<0>(n_thread_t) or n_thread > std::get<1>(n_thread_t)) {
+        std::cout << "error n_thread: " << n_thread << std::endl;
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string tables;
+    u64 n_thread;
+    u64 memory;
+    u64 bfs_memory;
+    std::string bfs_strategy;
+    bool bfs_telemetry;
+    u64 bfs_progress;
+    bool bfs_sample;
+    bool cache_compress;
+    std::string cache_verify;
+    std::string manifest;
+
+    parse_arg(argc, argv, tables, n_thread, memory, bfs_memory, bfs_strategy, bfs_telemetry, bfs_progress,
+              bfs_sample, cache_compress, cache_verify, manifest);
+
+    cache_options.n_stream = n_thread;
+    cache_options.compress = cache_compress;
+    cache_options.verify = cache_verify;
+    cache_options.bfs_memory = bfs_memory << 20;
+    cache_options.bfs_strategy = bfs_strategy;
+    cache_options.bfs_telemetry = bfs_telemetry;
+    cache_options.bfs_progress = bfs_progress;
+    cache_options.bfs_sample = bfs_sample;
+
+    std::vector<target> targets = all_targets();
+    if (tables != "all") {
+        std::vector<target> selected{};
+        std::stringstream ss(tables);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            auto it = std::find_if(targets.begin(), targets.end(), [&name](const target &t) -> bool {
+                return t.name == name;
+            });
+            if (it == targets.end()) {
+                std::cout << "error tables: " << name << std::endl;
+                exit(1);
+            }
+            selected.push_back(*it);
+        }
+        targets = selected;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    try {
+        build(targets, n_thread, memory << 20);
+    } catch (const std::runtime_error &e) {
+        std::cout << "error cache: " << e.what() << std::endl;
+        exit(1);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::chrono::duration<double> d = t1 - t0;
+
+    std::vector<_cache_event> events = cache_events();
+    std::sort(events.begin(), events.end(), [](const _cache_event &a, const _cache_event &b) -> bool {
+        return a.name < b.name;
+    });
+    std::unique_ptr<std::ofstream> manifest_f = manifest.empty() ? nullptr : std::make_unique<std::ofstream>(manifest);
+    for (const _cache_event &e: events) {
+        std::string digest = sha256::to_string(e.sha256);
+        std::cout << "tablegen: table " << e.name << ", action=" << e.action << ", time=" << e.end - e.start
+                  << "s, size=" << e.size << ", sha256=" << digest;
+        if (not e.verify.empty()) {
+            std::cout << ", verify=" << e.verify;
+        }
+        std::cout << std::endl;
+        if (manifest_f != nullptr) {
+            *manifest_f << digest << "  " << e.name << std::endl;
+        }
+    }
+    auto[rss, hwm] = read_rss();
+    std::cout << "tablegen: n_target=" << targets.size() << ", n_table=" << events.size() << ", time=" << d.count()
+              << "s, process_peak_rss=" << hwm << std::endl;
+    return 0;
+}
@@ -59,6 +59,285 @@ void test_one(u64 n_thread, u64 seed, u64 n_cube, u64 rand_n_moves, u64 max_n_mo
     }
 }
 
+//  the class representatives and the table_conj_mul of the edges of p0s built on n_thread threads
+//  are the same as those built on one thread
+void test_conj_mul(u64 n_thread) {
+    std::cout << "##################################################" << std::endl;
+    typedef p0s_solver _solver;
+    constexpr u64 n_eo = _solver::n_eo;
+    constexpr u64 n_base = _solver::n_base;
+    typedef table_conj_mul<u32, u16, u16, _solver::n_egp * n_eo, _solver::n_sc_egp_eo, n_s16, n_base> t_table;
+    auto conj = [](u32 i) -> std::array<u32, n_s16> {
+        cube3 a = cube3::i();
+        a.ep = gp_to_p<os_4_8>(int_to_gp<os_4_8>(i / n_eo));
+        a.eo = int_to_o<12, 2>(i % n_eo);
+        std::array<u32, n_s16> conj_i{};
+        for (u64 s = 0; s < n_s16; s++) {
+            cube3 b = elements_s16[inv_s16[s]] * a * elements_s16[s];
+            conj_i[s] = u32(gp_to_int<os_4_8>(p_to_gp<os_4_8>(b.ep)) * n_eo + o_to_int<12, 2>(b.eo));
+        }
+        return conj_i;
+    };
+    auto mul = [](u32 i) -> std::array<u32, n_base> {
+        array_u8<12> egp = int_to_gp<os_4_8>(i / n_eo);
+        array_u8<12> eo = int_to_o<12, 2>(i % n_eo);
+        std::array<u32, n_base> mul_i{};
+        for (u64 j = 0; j < n_base; j++) {
+            mul_i[j] = u32(gp_to_int<os_4_8>(egp * _solver::base[j].ep) * n_eo
+                           + o_to_int<12, 2>(mul_o<12, 2>(eo * _solver::base[j].ep, _solver::base[j].eo)));
+        }
+        return mul_i;
+    };
+    u64 n_parallel = std::max(n_thread, u64(3));
+    std::vector<u32> reps_serial = generate_class_representatives<u32, _solver::n_egp * n_eo, n_s16>(conj, 1);
+    std::vector<u32> reps_parallel = generate_class_representatives<u32, _solver::n_egp * n_eo, n_s16>(
+            conj, n_parallel);
+    assert(reps_serial.size() == _solver::n_sc_egp_eo);
+    assert(reps_serial == reps_parallel);
+    std::shared_ptr<t_table> serial = cache_alloc<t_table>();
+    std::shared_ptr<t_table> parallel = cache_alloc<t_table>();
+    serial->init(conj, mul, 1);
+    parallel->init(conj, mul, n_parallel);
+    assert(std::memcmp(serial.get(), parallel.get(), sizeof(t_table)) == 0);
+    std::cout << "test_conj_mul: n_sc=" << reps_serial.size() << ", n_thread=" << n_parallel << ", same=1" << std::endl;
+}
+
+//  a bfs resumed from a checkpoint saved after a depth builds the same table as a bfs run at once,
+//  the checkpoint is saved by a bfs without a name, as a build stopped after that depth would have left it,
+//  in cache_data it is kept until the table is saved
+void test_bfs_resume(u64 n_thread) {
+    std::cout << "##################################################" << std::endl;
+    typedef cube2_solver _solver;
+    constexpr u64 n_state = _solver::n_state;
+    constexpr u64 stop_depth = 6;
+    _solver s(n_thread);
+    std::string name = "test.bfs_resume";
+    std::shared_ptr<array_u2<n_state>> a = cache_alloc<array_u2<n_state>>();
+    bfs<_solver>(s, *a, n_thread, "", [&](u64 depth) -> void {
+        if (depth != stop_depth) {
+            return;
+        }
+        bfs_checkpoint c{n_state, depth, 0, 0, {0, 0, 0}};
+        for (u64 i = 0; i < n_state; i++) {
+            u64 x = a->get(i);
+            if (x != 3) {
+                c.count_m3[x]++;
+                c.total_count++;
+            }
+        }
+        c.total_count_distinct = c.total_count;
+        _bfs_save<n_state>(name, c, *a, n_thread);
+    });
+    std::string path = "cache/" + name + ".checkpoint";
+    std::filesystem::copy_file(path, path + ".stopped", std::filesystem::copy_options::overwrite_existing);
+    assert(std::memcmp(a.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+
+    u64 checkpoint = cache_options.checkpoint;
+    cache_options.checkpoint = 3600;
+    std::shared_ptr<array_u2<n_state>> b = cache_alloc<array_u2<n_state>>();
+    bfs_checkpoint c{};
+    assert(_bfs_load<n_state>(name, c, *b, n_thread) and c.depth == stop_depth);
+    b->fill(0);
+    bfs<_solver>(s, *b, n_thread, name);
+    assert(not std::filesystem::exists(path));
+    assert(std::memcmp(b.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+
+    std::filesystem::rename(path + ".stopped", path);
+    std::filesystem::remove("cache/" + name);
+    cache_ptr<array_u2<n_state>> d = cache_data<array_u2<n_state>>(name, [&](array_u2<n_state> &t) -> void {
+        bfs<_solver>(s, t, n_thread, name);
+        assert(std::filesystem::exists(path));
+    });
+    cache_options.checkpoint = checkpoint;
+    assert(not std::filesystem::exists(path));
+    assert(std::memcmp(d.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+    d = nullptr;
+    std::filesystem::remove("cache/" + name);
+}
+
+//  the partitioned bfs and the bfs with compare and swap build the table the solver has, on n_thread threads
+template<typename _solver>
+void test_bfs_strategy(u64 n_thread) {
+    std::cout << "##################################################" << std::endl;
+    constexpr u64 n_state = _solver::n_state;
+    _solver s(n_thread);
+    std::string bfs_strategy = cache_options.bfs_strategy;
+    for (const char *strategy: {"partition", "cas"}) {
+        cache_options.bfs_strategy = strategy;
+        std::shared_ptr<array_u2<n_state>> a = cache_alloc<array_u2<n_state>>();
+        bfs<_solver>(s, *a, std::max(n_thread, u64(3)));
+        assert(std::memcmp(a.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+    }
+    cache_options.bfs_strategy = bfs_strategy;
+}
+
+//  the scans of the words of an array_u2 which the cpu supports find the word the scalar one finds,
+//  for a match at each word of short ranges, so in the vector words and in the tail words after them
+void test_u2_scanner() {
+    std::cout << "##################################################" << std::endl;
+    std::vector<std::tuple<const char *, u64 (*)(const u64 *, u64, u64, u64)>> scanners{{"scalar", _find_u2_scalar}};
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        scanners.emplace_back("avx2", _find_u2_avx2);
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        scanners.emplace_back("avx512", _find_u2_avx512);
+    }
+#endif
+    constexpr u64 n_word = 40;
+    std::vector<u64> p(n_word);
+    for (u64 x = 0; x < 4; x++) {
+        for (u64 match = 0; match <= n_word; match++) {
+            for (u64 k = 0; k < 32; k += 7) {
+                std::fill(p.begin(), p.end(), (x + 1) % 4 * _u2_low);
+                if (match < n_word) {
+                    p[match] = (p[match] & ~(u64(3) << (k * 2))) | (x << (k * 2));
+                }
+                for (u64 w = 0; w < 3; w++) {
+                    for (u64 w_end = w; w_end <= n_word; w_end++) {
+                        u64 expected = match >= w and match < w_end ? match : w_end;
+                        assert(_find_u2_scalar(p.data(), w, w_end, x) == expected);
+                        for (const auto &[isa, find]: scanners) {
+                            assert(find(p.data(), w, w_end, x) == expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (const auto &[isa, find]: scanners) {
+        std::cout << "test_u2_scanner: " << isa << " ok" << std::endl;
+    }
+}
+
+//  a cache file is read back as it was saved, and a file with a damaged header, a section cut short,
+//  a table of another type or a damaged table is rejected
+void test_cache_file() {
+    std::cout << "##################################################" << std::endl;
+    typedef array_2d<u16, 1000, 18> t_table;
+    std::string name = "test.cache_file";
+    std::string path = "cache/" + name;
+    std::shared_ptr<t_table> a = cache_alloc<t_table>();
+    for (u64 i = 0; i < 1000; i++) {
+        for (u64 j = 0; j < 18; j++) {
+            (*a)[i][j] = u16(i * 7 + j * 13);
+        }
+    }
+    bool compress = cache_options.compress;
+    std::string verify = cache_options.verify;
+    cache_options.compress = false;
+    cache_options.verify = "rebuild";
+    _cache_save<t_table>("cache/", name, *a);
+    auto[found, error, found_path, section] = _cache_find<t_table>("cache/", name);
+    assert(found and error.empty() and found_path == path and section.type == cache_type_name<t_table>());
+    auto[p, p_verify] = _cache_read<t_table>(name, path, section);
+    assert(p != nullptr and p_verify == "ok" and std::memcmp(p.get(), a.get(), sizeof(t_table)) == 0);
+    assert(std::get<1>(_cache_find<array_2d<u32, 500, 18>>("cache/", name)).rfind("bad type", 0) == 0);
+
+    std::string file{};
+    {
+        std::ifstream f(path, std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    auto rewrite = [&path](const std::string &content) -> void {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f.write(content.data(), std::streamsize(content.size()));
+    };
+    std::string damaged = file;
+    damaged[0] ^= 1;
+    rewrite(damaged);
+    assert(std::get<1>(read_cache_header(path)) == "bad magic");
+    damaged = file;
+    damaged[sizeof(_cache_file_header) + 1] ^= 1;
+    rewrite(damaged);
+    assert(std::get<1>(read_cache_header(path)) == "bad header checksum");
+    rewrite(file.substr(0, section.offset + sizeof(t_table) / 2));
+    assert(std::get<1>(read_cache_header(path)) == "bad section 0");
+    damaged = file;
+    damaged[section.offset + 100] ^= 1;
+    rewrite(damaged);
+    assert(std::get<1>(_cache_read<t_table>(name, path, section)) == "failed");
+
+    cache_options.compress = compress;
+    cache_options.verify = verify;
+    std::filesystem::remove(path);
+}
+
+//  huffman_codec decodes what it encodes, for stored and coded blocks, and rejects a cut or damaged block,
+//  a compressed cache file of several chunks is read back as it was saved and a damaged chunk is rejected
+void test_huffman() {
+    std::cout << "##################################################" << std::endl;
+    std::mt19937_64 rand(0);
+    std::vector<std::vector<u8>> inputs{{}, std::vector<u8>(4096, 7), {}, {}};
+    for (u64 i = 0; i < 100000; i++) {
+        inputs[2].push_back(u8(rand()));
+        inputs[3].push_back(u8(rand() % 16 == 0 ? rand() : rand() % 3));
+    }
+    for (const std::vector<u8> &src: inputs) {
+        std::vector<u8> block = huffman_codec::compress(src.data(), src.size());
+        std::vector<u8> dst(src.size());
+        assert(huffman_codec::decompress(block.data(), block.size(), dst.data(), dst.size()) and dst == src);
+        if (src.size() > 0) {
+            assert(not huffman_codec::decompress(block.data(), block.size() - 1, dst.data(), dst.size()));
+        }
+    }
+    std::vector<u8> block = huffman_codec::compress(inputs[3].data(), inputs[3].size());
+    std::vector<u8> dst(inputs[3].size());
+    assert(block[0] == 1 and block.size() < inputs[3].size() / 2);
+    block[0] = 2;
+    assert(not huffman_codec::decompress(block.data(), block.size(), dst.data(), dst.size()));
+
+    typedef array_2d<u8, 3, cache_codec_chunk_size> t_table;
+    std::string name = "test.huffman";
+    std::string path = "cache/" + name;
+    std::shared_ptr<t_table> a = cache_alloc<t_table>();
+    for (u64 i = 0; i < 3; i++) {
+        for (u64 j = 0; j < cache_codec_chunk_size; j++) {
+            (*a)[i][j] = u8(j % 97 == 0 ? j / 97 : i);
+        }
+    }
+    bool compress = cache_options.compress;
+    std::string verify = cache_options.verify;
+    cache_options.compress = true;
+    cache_options.verify = "rebuild";
+    _cache_save<t_table>("cache/", name, *a);
+    auto[found, error, found_path, section] = _cache_find<t_table>("cache/", name);
+    assert(found and error.empty() and section.codec == cache_codec_huffman and section.size < sizeof(t_table) / 2);
+    auto[p, p_verify] = _cache_read<t_table>(name, path, section);
+    assert(p != nullptr and p_verify == "ok" and std::memcmp(p.get(), a.get(), sizeof(t_table)) == 0);
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(std::streamoff(section.offset + section.size - 100));
+        f.put(char(0xff));
+    }
+    assert(std::get<0>(_cache_read<t_table>(name, path, section)) == nullptr);
+    cache_options.compress = compress;
+    cache_options.verify = verify;
+    std::filesystem::remove(path);
+}
+
+//  a table built on disk in a budget of a few partitions is the same as the table built in memory,
+//  both when it is streamed to its cache file in cache_data and when it is copied into distance_m3
+template<typename _solver>
+void test_bfs_external(u64 n_thread) {
+    std::cout << "##################################################" << std::endl;
+    constexpr u64 n_state = _solver::n_state;
+    _solver s(n_thread);
+    std::string name = "test.bfs_external";
+    u64 bfs_memory = cache_options.bfs_memory;
+    cache_options.bfs_memory = u64(1) << 16;
+    std::filesystem::remove("cache/" + name);
+    cache_ptr<array_u2<n_state>> a = cache_data<array_u2<n_state>>(name, [&](array_u2<n_state> &t) -> void {
+        bfs<_solver>(s, t, n_thread, name);
+    });
+    std::shared_ptr<array_u2<n_state>> b = cache_alloc<array_u2<n_state>>();
+    bfs<_solver>(s, *b, n_thread, name);
+    cache_options.bfs_memory = bfs_memory;
+    std::filesystem::remove("cache/" + name);
+    assert(std::memcmp(a.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+    assert(std::memcmp(b.get(), s.distance_m3.get(), sizeof(array_u2<n_state>)) == 0);
+}
+
 void test(u64 n_thread, u64 seed, bool full) {
     constexpr u64 capacity = 20;
     u64 n_cube = 3;
@@ -69,9 +348,31 @@ void test(u64 n_thread, u64 seed, bool full) {
     test_one<cube2_solver, capacity, solved_check<cube2_solver>>(
             n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
 
+    test_one<cube2_exact_solver, capacity, solved_check<cube2_exact_solver>>(
+            n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
+
+    test_bfs_external<cube2_solver>(n_thread);
+
+    test_conj_mul(n_thread);
+
+    test_bfs_resume(n_thread);
+
+    test_bfs_strategy<cube2_solver>(n_thread);
+
+    test_bfs_strategy<p0s_solver>(n_thread);
+
+    test_u2_scanner();
+
+    test_cache_file();
+
+    test_huffman();
+
     test_one<p0s_solver, capacity, partial_check<p0s_solver>>(
             n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
 
+    test_one<p0s_exact_solver, capacity, partial_check<p0s_exact_solver>>(
+            n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
+
     test_one<p1s_solver, capacity, solved_check<p1s_solver>>(
             n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
 
@@ -81,6 +382,9 @@ void test(u64 n_thread, u64 seed, bool full) {
     test_one<c8_solver, capacity, partial_check<c8_solver>>(
             n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
 
+    test_one<c8_exact_solver, capacity, partial_check<c8_exact_solver>>(
+            n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
+
     test_one<p0sx_solver, capacity, partial_check<p0sx_solver>>(
             n_thread, seed, n_cube, rand_n_moves, max_n_moves, max_n_solution);
 